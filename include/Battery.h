@@ -0,0 +1,181 @@
+#pragma once
+
+#include <Arduino.h>
+#include <estd/algorithm.h>
+#include <estd/array.h>
+
+/**
+ * LiPo battery state estimator
+ *
+ * Estimates internal resistance from the voltage response to current steps, derives the open-circuit (no-load)
+ * voltage from it and maps that onto a per-cell charge curve. All arithmetic is in mV, mA and mOhm integers.
+ *
+ * The charge follows the curve at a limited rate, so load steps the resistance estimate has not caught up with yet
+ * (or a current measured out of step with the voltage) do not show as jumps on the gauge or in the throttle limit.
+ */
+class Battery
+{
+public:
+    static constexpr uint8_t MAX_CELLS = 4;
+
+    // resting LiPo cell voltage [mV] at 0%, 10%, ... 100% charge
+    static constexpr int16_t CELL_MV_EMPTY = 3300;
+    static constexpr int16_t CELL_MV_FULL = 4200;
+
+    // charge below which the throttle is limited [%]
+    static constexpr int16_t LOW_CHARGE = 20;
+
+    /**
+     * Detect cell count from the (unloaded) pack voltage
+     *
+     * Assumes the pack is not discharged below ~3.4 V/cell when connected, which is needed to tell a flat 4S from
+     * a full 3S pack.
+     */
+    void detectCells()
+    {
+        _cells = estd::clamp((_voltage + CELL_MV_DETECT - 1) / CELL_MV_DETECT, 1, static_cast<int16_t>(MAX_CELLS));
+        _charge = chargeFromCellVoltage(_ocv / _cells) << 8;
+    }
+
+    /**
+     * Update estimate with a new measurement
+     *
+     * @param mv Bus voltage [mV]
+     * @param ma Battery current [mA]
+     */
+    void update(int16_t mv, int16_t ma)
+    {
+        if (!_initialized)
+        {
+            _voltage = _slow_voltage = _ocv = mv;
+            _current = _slow_current = ma;
+            _charge = chargeFromCellVoltage(_ocv / _cells) << 8;
+            _initialized = true;
+        }
+
+        _voltage += (mv - _voltage) / 4;
+        _current += (ma - _current) / 4;
+
+        // internal resistance from deviation against slowly filtered operating point: R = -dV / dI
+        int16_t di = _current - _slow_current;
+        int16_t dv = _voltage - _slow_voltage;
+        if (di > MIN_STEP_MA || di < -MIN_STEP_MA)
+        {
+            int16_t r = static_cast<int16_t>((-static_cast<int32_t>(dv) * 1000) / di);
+            r = estd::clamp(r, static_cast<int16_t>(MIN_RESISTANCE), static_cast<int16_t>(MAX_RESISTANCE));
+            _resistance += (r - _resistance) / 16;
+        }
+
+        _slow_voltage += (_voltage - _slow_voltage) / 32;
+        _slow_current += (_current - _slow_current) / 32;
+
+        // open-circuit voltage: compensate sag I * R
+        int16_t ocv = _voltage + static_cast<int16_t>((static_cast<int32_t>(_current) * _resistance) / 1000);
+        _ocv += (ocv - _ocv) / 16;
+
+        // the pack cannot gain or lose charge faster than MAX_CHARGE_STEP allows: anything faster is load transient
+        int16_t charge = chargeFromCellVoltage(_ocv / _cells) << 8;
+        _charge += estd::clamp(static_cast<int16_t>(charge - _charge), static_cast<int16_t>(-MAX_CHARGE_STEP),
+            static_cast<int16_t>(MAX_CHARGE_STEP));
+    }
+
+    // true once a measurement was received
+    bool valid() const { return _initialized; }
+
+    uint8_t cells() const { return static_cast<uint8_t>(_cells); }
+
+    // filtered bus voltage [mV]
+    int16_t voltage() const { return _voltage; }
+
+    // filtered current [mA]
+    int16_t current() const { return _current; }
+
+    // estimated internal resistance [mOhm]
+    int16_t resistance() const { return _resistance; }
+
+    // estimated open-circuit voltage [mV]
+    int16_t ocv() const { return _ocv; }
+
+    // model terminal voltage at the present load, OCV - I * R [mV]; smoother than voltage()
+    int16_t terminalVoltage() const
+    {
+        return _ocv - static_cast<int16_t>((static_cast<int32_t>(_current) * _resistance) / 1000);
+    }
+
+    // remaining charge [%]
+    int16_t charge() const { return (_charge + 128) >> 8; }
+
+    /**
+     * Scale a command for the present voltage, so command * voltage (roughly fan power) stays what it was at \p ref_mv
+     *
+     * @param command Command tuned at \p ref_mv [us]
+     * @param zero Command of zero output [us]; only the part above it is scaled
+     * @param ref_mv Terminal voltage \p command was tuned at [mV]; 0 if unknown
+     * @return int16_t Compensated command, scaled by 0.75 .. 1.5 [us]
+     */
+    int16_t compensate(int16_t command, int16_t zero, int16_t ref_mv) const
+    {
+        int16_t v = terminalVoltage();
+        if (ref_mv <= 0 || v <= 0)
+            return command;
+
+        int16_t scale = estd::clamp(static_cast<int16_t>((static_cast<int32_t>(ref_mv) * 256) / v),
+            static_cast<int16_t>(MIN_COMPENSATION), static_cast<int16_t>(MAX_COMPENSATION));
+
+        return zero + ((static_cast<int32_t>(command - zero) * scale) >> 8);
+    }
+
+    /**
+     * Throttle limit for low battery
+     *
+     * @return int16_t 256 for full throttle, down to 128 (half throttle) for an empty pack
+     */
+    int16_t throttleLimit() const
+    {
+        int16_t percent = charge();
+        if (percent >= LOW_CHARGE)
+            return 256;
+
+        return 128 + (percent * 128) / LOW_CHARGE;
+    }
+
+private:
+    static int16_t chargeFromCellVoltage(int16_t cell_mv)
+    {
+        static const estd::array<int16_t, 11> CELL_MV = {
+            CELL_MV_EMPTY, 3690, 3730, 3770, 3790, 3820, 3870, 3930, 4000, 4080, CELL_MV_FULL
+        };
+
+        if (cell_mv <= CELL_MV[0])
+            return 0;
+
+        for (uint8_t i = 1; i < CELL_MV.size(); ++i)
+        {
+            if (cell_mv < CELL_MV[i])
+            {
+                // linear interpolation within 10% step
+                return (i - 1) * 10 + ((cell_mv - CELL_MV[i - 1]) * 10) / (CELL_MV[i] - CELL_MV[i - 1]);
+            }
+        }
+
+        return 100;
+    }
+
+    static constexpr int16_t CELL_MV_DETECT = 4250;
+    static constexpr int16_t MIN_STEP_MA = 500;
+    static constexpr int16_t MIN_RESISTANCE = 5;
+    static constexpr int16_t MAX_RESISTANCE = 500;
+    static constexpr int16_t MIN_COMPENSATION = 192;  // 0.75 (Q8)
+    static constexpr int16_t MAX_COMPENSATION = 384;  // 1.5 (Q8)
+    static constexpr int16_t MAX_CHARGE_STEP = 1;  // 1/256 % per update, 0.8 %/s at the 5 ms battery period
+
+    bool _initialized = false;
+    int16_t _cells = 2;
+    int16_t _voltage = 0;
+    int16_t _current = 0;
+    int16_t _slow_voltage = 0;
+    int16_t _slow_current = 0;
+    int16_t _resistance = 40;
+    int16_t _ocv = 0;
+    int16_t _charge = 100 << 8;  // [%] (Q8)
+};
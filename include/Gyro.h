@@ -10,6 +10,20 @@ static constexpr auto IS_INIT_VALUE = 42;
 class Gyro
 {
 public:
+    // raw sensitivity at +/- 500 degrees/sec
+    static constexpr float LSB_PER_DPS = 65.5f;
+
+    /**
+     * Yaw rate in the units returned by read() (rate / 16)
+     *
+     * @param dps Yaw rate [degrees/s]
+     * @return int16_t Rate [gyro units], rounded
+     */
+    static constexpr int16_t zUnits(float dps)
+    {
+        return static_cast<int16_t>(dps * LSB_PER_DPS / 16 + (dps < 0 ? -0.5f : 0.5f));
+    }
+
     void setup()
     {
         _device.initialize();
@@ -18,39 +32,188 @@ public:
         // 0 = +/- 250 degrees/sec | 1 = +/- 500 degrees/sec | 2 = +/- 1000 degrees/sec | 3 =  +/- 2000 degrees/sec
         _device.setFullScaleGyroRange(1);
 
+        // 0 = +/- 2 g (see SlipEstimator::LSB_PER_G)
+        _device.setFullScaleAccelRange(0);
+
         if (EEPROM.read(EEPROM_IS_INIT_ADDR) == IS_INIT_VALUE)
         {
-            _baseline = eeprom_read_int(EEPROM_GYRO_BASELINE_ADDR);
+            _bias_q4 = static_cast<int32_t>(static_cast<int16_t>(eeprom_read_int(EEPROM_GYRO_BASELINE_ADDR))) * 16;
+            _seeded = true;
         }
     }
 
-    int16_t read() const
+    /**
+     * Also read the accelerometer, in the same burst transaction as the gyro (14 instead of 2 bytes)
+     */
+    void enableMotion(bool enable = true) { _motion = enable; }
+
+    int16_t read()
     {
-        // remove baseline
-        int16_t gz = _device.getRotationZ() - _baseline;
+        _held_raw = _raw;
+        _held_accel_x = _accel_x;
+        _held_accel_y = _accel_y;
+        _held_activity = _activity;
+
+        if (_motion)
+        {
+            int16_t az, gx, gy;
+            _device.getMotion6(&_accel_x, &_accel_y, &az, &gx, &gy, &_raw);
+        }
+        else
+        {
+            _raw = _device.getRotationZ();
+        }
+
+        // remove estimated bias (Q4, rounded)
+        _rate = _raw - baseline();
+
+        // stillness detector: mean absolute sample-to-sample change and current rate both small; without a bias
+        // estimate yet (first boot) the rate can be off by the full sensor offset, so only the activity counts
+        int16_t delta = _raw - _prev_raw;
+        _prev_raw = _raw;
+        _activity += (abs(delta) - _activity) / 8;
+
+        if (_activity < STILL_ACTIVITY && (!_seeded || (_rate > -STILL_RATE && _rate < STILL_RATE)))
+        {
+            if (_still_count < STILL_FRAMES)
+            {
+                _window_sum += _raw;
+            }
+            if (_still_count < 255)
+            {
+                ++_still_count;
+            }
+        }
+        else
+        {
+            _still_count = 0;
+            _window_sum = 0;
+        }
 
         // write_rc_outputs ~degrees per second (assuming gyro mode 2)
-        return gz / 16;
+        return _rate / 16;
+    }
+
+    /**
+     * Discard the sample of the last read(), e.g. after the transaction timed out, and restore the one before
+     *
+     * The stillness window restarts, so no bias update spans the lost sample.
+     *
+     * @return int16_t Yaw rate of the restored sample, as read() [gyro units]
+     */
+    int16_t hold()
+    {
+        _raw = _prev_raw = _held_raw;
+        _accel_x = _held_accel_x;
+        _accel_y = _held_accel_y;
+        _activity = _held_activity;
+        _rate = _raw - baseline();
+
+        _still_count = 0;
+        _window_sum = 0;
+
+        return _rate / 16;
     }
 
-    int16_t baseline() const { return _baseline; }
+    // yaw rate of last read() at full resolution [LSB]
+    int16_t rate() const { return _rate; }
+
+    // acceleration of last read() along the sensor x (forward) and y (left) axes [LSB], with enableMotion() only
+    int16_t accelX() const { return _accel_x; }
+    int16_t accelY() const { return _accel_y; }
+
+    // current bias estimate [LSB]
+    int16_t baseline() const { return static_cast<int16_t>((_bias_q4 + 8) >> 4); }
+
+    // true once the sensor has been still for long enough to update the bias
+    bool still() const { return _still_count >= STILL_FRAMES; }
+
+    // true once a bias estimate exists, from EEPROM or a still window
+    bool seeded() const { return _seeded; }
 
-    void calibrate()
+    /**
+     * Update the bias estimate from the sample of the last read(), if the sensor is still
+     *
+     * Non-blocking; call once per frame while the craft is known not to be turning on purpose. Without a bias
+     * estimate, the first still window seeds it, unless \p shift is BIAS_SHIFT_HOVER (a slow steady turn is as quiet
+     * as standing still).
+     *
+     * @param shift Filter time constant as power of two [frames], e.g. BIAS_SHIFT_IDLE
+     */
+    void updateBias(uint8_t shift)
     {
-        const int16_t N = 32;
-        int32_t sum = 0;
+        if (!still())
+            return;
 
-        for (int16_t i = 0; i < N; ++i)
+        if (_seeded)
         {
-            sum += _device.getRotationZ();
+            _bias_q4 += ((static_cast<int32_t>(_raw) * 16) - _bias_q4) >> shift;
         }
-        _baseline = static_cast<int16_t>(sum / N);
+        else if (shift < BIAS_SHIFT_HOVER)
+        {
+            _bias_q4 = (_window_sum * 16) / STILL_FRAMES;
+            _seeded = true;
+        }
+    }
 
-        eeprom_write(EEPROM_GYRO_BASELINE_ADDR, _baseline);
+    /**
+     * Restart calibration: the next still samples must be seen before calibrate() returns true
+     */
+    void startCalibration()
+    {
+        _still_count = 0;
+        _window_sum = 0;
+        _calibration_count = 0;
+    }
+
+    /**
+     * Update the bias quickly while calibrating
+     *
+     * @return \c true once enough still samples were seen; the baseline is then stored in EEPROM
+     */
+    bool calibrate()
+    {
+        if (!still())
+            return false;
+
+        updateBias(BIAS_SHIFT_CALIBRATION);
+
+        if (++_calibration_count < CALIBRATION_FRAMES)
+            return false;
+
+        eeprom_write(EEPROM_GYRO_BASELINE_ADDR, baseline());
         EEPROM.write(EEPROM_IS_INIT_ADDR, IS_INIT_VALUE);
-    } 
+        return true;
+    }
+
+    static constexpr uint8_t BIAS_SHIFT_CALIBRATION = 3;
+    static constexpr uint8_t BIAS_SHIFT_IDLE = 6;
+    static constexpr uint8_t BIAS_SHIFT_HOVER = 9;
 
 private:
-    int16_t _baseline;
-    mutable MPU6050 _device;
+    static constexpr int16_t STILL_RATE = static_cast<int16_t>(2 * LSB_PER_DPS);
+    static constexpr int16_t STILL_ACTIVITY = static_cast<int16_t>(LSB_PER_DPS / 2);
+    static constexpr uint8_t STILL_FRAMES = 8;
+    static constexpr uint8_t CALIBRATION_FRAMES = 32;
+
+    int32_t _bias_q4 = 0;
+    int16_t _raw = 0;
+    int16_t _prev_raw = 0;
+    int16_t _rate = 0;
+    int16_t _activity = 0;
+    int32_t _window_sum = 0;  // of the raw samples of the first STILL_FRAMES still frames
+    uint8_t _still_count = 0;
+    uint8_t _calibration_count = 0;
+    bool _motion = false;
+    bool _seeded = false;
+    int16_t _accel_x = 0;
+    int16_t _accel_y = 0;
+
+    // sample before the last read(), restored by hold()
+    int16_t _held_raw = 0;
+    int16_t _held_accel_x = 0;
+    int16_t _held_accel_y = 0;
+    int16_t _held_activity = 0;
+
+    MPU6050 _device;
 };
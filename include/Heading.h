@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Gyro.h"
+#include "Timer.h"
+#include <Arduino.h>
+
+/**
+ * Heading integrated from the gyro yaw rate
+ *
+ * The heading is a binary angle (65536 == 360 degrees), so differences between headings wrap correctly when taken as
+ * int16_t. Integration uses the Timer count of each sample, not a nominal frame period.
+ */
+class Heading
+{
+public:
+    // integration step: 8 us (16 Timer counts)
+    static constexpr uint8_t DT_SHIFT = 4;
+
+    // rate * dt [LSB * 8 us] per binary angle unit
+    static constexpr int32_t RATE_DT_PER_UNIT =
+        static_cast<int32_t>(Gyro::LSB_PER_DPS * (360.0f / 65536.0f) * (1000000.0f / 8.0f) + 0.5f);
+
+    // longest integration step accepted (keeps rate * dt inside int32_t)
+    static constexpr uint32_t MAX_DT_COUNT = 0xffffUL;
+
+    /**
+     * Restart integration at \p now without changing the heading
+     *
+     * @param now Timer count
+     */
+    void restart(uint32_t now)
+    {
+        _last_count = now;
+        _remainder = 0;
+    }
+
+    /**
+     * Integrate one yaw rate sample
+     *
+     * @param rate Yaw rate [gyro LSB]
+     * @param now Timer count when the sample was taken
+     */
+    void integrate(int16_t rate, uint32_t now)
+    {
+        uint32_t dt = now - _last_count;
+        _last_count = now;
+
+        if (dt > MAX_DT_COUNT)
+        {
+            dt = MAX_DT_COUNT;
+        }
+
+        _remainder += static_cast<int32_t>(rate) * static_cast<int16_t>(dt >> DT_SHIFT);
+
+        int32_t step = _remainder / RATE_DT_PER_UNIT;
+        _remainder -= step * RATE_DT_PER_UNIT;
+        _heading += static_cast<uint16_t>(step);
+    }
+
+    // heading [binary angle]
+    uint16_t value() const { return _heading; }
+
+    // heading [degrees], for telemetry
+    int16_t degrees() const { return static_cast<int16_t>((static_cast<int32_t>(static_cast<int16_t>(_heading)) * 360) >> 16); }
+
+private:
+    uint16_t _heading = 0;
+    int32_t _remainder = 0;
+    uint32_t _last_count = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "StateMachine.h"
+#include <Arduino.h>
+
+enum class State
+{
+    Init,
+    Calibration,
+    Idle,
+    Hover,
+    FailSafe,
+    Tune,
+    Count
+};
+
+struct RxData
+{
+    int16_t thrust_us;
+    int16_t dir_us;
+    int16_t hover_us;
+};
+
+// input of one control frame, passed to all state actions
+struct Frame
+{
+    RxData rx;
+    int16_t gyro_z;
+};
+
+typedef StateMachine<State, Frame, static_cast<uint8_t>(State::Count)> HoverStateMachine;
+
+// state machine events
+constexpr uint8_t EVENT_FAIL_SAFE = bit(0);
+constexpr uint8_t EVENT_TOGGLE_HOVER = bit(1);
+constexpr uint8_t EVENT_TUNE = bit(2);
+constexpr uint8_t EVENT_INIT_DONE = bit(3);
+constexpr uint8_t EVENT_CALIBRATED = bit(4);
+constexpr uint8_t EVENT_COUNT = 5;
+
+// toggling hover with the steering stick held over selects heading hold
+void select_heading_hold(const Frame& frame);
+
+// evaluated in order, first match wins
+constexpr HoverStateMachine::Transition TRANSITIONS[] PROGMEM = {
+    {State::Init, EVENT_INIT_DONE, EVENT_INIT_DONE, State::Idle, nullptr},
+
+    {State::Idle, EVENT_FAIL_SAFE | EVENT_TOGGLE_HOVER | EVENT_TUNE, EVENT_TOGGLE_HOVER, State::Hover,
+        select_heading_hold},
+    {State::Idle, EVENT_FAIL_SAFE | EVENT_TOGGLE_HOVER | EVENT_TUNE, EVENT_TOGGLE_HOVER | EVENT_TUNE,
+        State::Calibration, nullptr},
+
+    {State::Calibration, EVENT_FAIL_SAFE, EVENT_FAIL_SAFE, State::Idle, nullptr},
+    {State::Calibration, EVENT_TOGGLE_HOVER, EVENT_TOGGLE_HOVER, State::Idle, nullptr},
+    {State::Calibration, EVENT_CALIBRATED, EVENT_CALIBRATED, State::Tune, nullptr},
+
+    {State::Hover, EVENT_FAIL_SAFE, EVENT_FAIL_SAFE, State::FailSafe, nullptr},
+    {State::Hover, EVENT_TOGGLE_HOVER, EVENT_TOGGLE_HOVER, State::Idle, nullptr},
+
+    {State::FailSafe, EVENT_FAIL_SAFE, 0, State::Hover, nullptr},
+
+    {State::Tune, EVENT_FAIL_SAFE, EVENT_FAIL_SAFE, State::Idle, nullptr},
+    {State::Tune, EVENT_TOGGLE_HOVER, EVENT_TOGGLE_HOVER, State::Idle, nullptr},
+    {State::Tune, EVENT_TUNE, 0, State::Idle, nullptr},
+};
+
+constexpr uint8_t TRANSITION_COUNT = sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0]);
+
+static_assert(HoverStateMachine::valid(TRANSITIONS, EVENT_COUNT), "transition row with invalid state or events");
+static_assert(HoverStateMachine::exits(TRANSITIONS), "state without transition out");
+static_assert(HoverStateMachine::reachable(TRANSITIONS, State::Init), "state not reachable");
+static_assert(HoverStateMachine::unshadowed(TRANSITIONS), "transition row never fires");
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+/**
+ * I2C bus supervision: bounded transactions and recovery of a stuck bus
+ *
+ * Wire transactions time out instead of waiting forever for a missing device or a slave holding SDA low; the TWI is
+ * reset on a timeout and the transaction fails. check() then recovers the bus: it clocks SCL until the slave
+ * releases SDA (at most 9 clocks finish any byte in progress), sends a STOP and restarts the TWI. The devices keep
+ * their configuration, so only the failed transaction is lost.
+ */
+class I2cBus
+{
+public:
+    // MPU6050 and INA219 both support fast mode
+    static constexpr uint32_t CLOCK_HZ = 400000;
+
+    // longest wait for the bus within a transaction [us]; the 14 byte motion burst takes ~0.4 ms
+    static constexpr uint32_t TIMEOUT_US = 1000;
+
+    /**
+     * Set clock and timeout; call after Wire.begin()
+     */
+    void setup()
+    {
+        Wire.setClock(CLOCK_HZ);
+        Wire.setWireTimeout(TIMEOUT_US, true);
+    }
+
+    /**
+     * Recover the bus if a transaction timed out since the last call; main loop only
+     *
+     * @return \c true if a transaction timed out (its data is invalid)
+     */
+    bool check()
+    {
+        if (!Wire.getWireTimeoutFlag())
+            return false;
+
+        Wire.clearWireTimeoutFlag();
+        if (_timeouts < 0xffff)
+        {
+            ++_timeouts;
+        }
+
+        recover();
+        return true;
+    }
+
+    // transactions timed out since reset (saturating)
+    uint16_t timeouts() const { return _timeouts; }
+
+private:
+    static constexpr uint8_t RECOVERY_CLOCKS = 9;
+    static constexpr uint8_t HALF_PERIOD_US = 5;  // 100 kHz
+
+    void recover()
+    {
+        Wire.end();
+
+        // open drain by hand: drive low as output (output latch low first), release as input with pull-up
+        pinMode(SDA, INPUT_PULLUP);
+        pinMode(SCL, INPUT_PULLUP);
+
+        for (uint8_t i = 0; i < RECOVERY_CLOCKS && digitalRead(SDA) == LOW; ++i)
+        {
+            digitalWrite(SCL, LOW);
+            pinMode(SCL, OUTPUT);
+            delayMicroseconds(HALF_PERIOD_US);
+            pinMode(SCL, INPUT_PULLUP);
+            delayMicroseconds(HALF_PERIOD_US);
+        }
+
+        // STOP: SDA rises while SCL is high
+        digitalWrite(SDA, LOW);
+        pinMode(SDA, OUTPUT);
+        delayMicroseconds(HALF_PERIOD_US);
+        pinMode(SDA, INPUT_PULLUP);
+        delayMicroseconds(HALF_PERIOD_US);
+
+        Wire.begin();
+        setup();
+    }
+
+private:
+    uint16_t _timeouts = 0;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace int_math {
+
+// integer square root (Newton iteration from n / 2, which is at least the root for n >= 2 and cannot overflow),
+// usable in constant expressions
+constexpr uint32_t isqrt_iter(uint32_t n, uint32_t x, uint32_t y)
+{
+    return y >= x ? x : isqrt_iter(n, y, (y + n / y) / 2);
+}
+
+constexpr uint32_t isqrt(uint32_t n)
+{
+    return n < 2 ? n : isqrt_iter(n, n, n / 2);
+}
+
+}  // namespace int_math
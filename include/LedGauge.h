@@ -1,186 +1,241 @@
 #pragma once
 
+#include "IntMath.h"
 #include "Timer.h"
 #include <Adafruit_NeoPixel.h>
-#include <estd/array.h>
+#include <avr/pgmspace.h>
 #ifdef __AVR__
 #include <avr/power.h>
 #endif
 
 constexpr uint8_t NUM_PIXEL = 5;
 
+namespace led_palette {
+
+// gamma correction (~2.5: v^2 * sqrt(v)), usable in constant expressions
+constexpr uint8_t gamma8(uint8_t v)
+{
+    return static_cast<uint8_t>(
+        (static_cast<uint32_t>(v) * v * int_math::isqrt(static_cast<uint32_t>(v) * 255)) / (255UL * 255));
+}
+
+// gamma corrected color
+constexpr uint32_t color(uint8_t r, uint8_t g, uint8_t b)
+{
+    return (static_cast<uint32_t>(gamma8(r)) << 16) | (static_cast<uint32_t>(gamma8(g)) << 8) | gamma8(b);
+}
+
+// color wheel: red - green - blue - red
+constexpr uint32_t wheel(uint8_t pos)
+{
+    return pos < 85 ? color(pos * 3, 255 - pos * 3, 0)
+        : pos < 170 ? color(255 - (pos - 85) * 3, 0, (pos - 85) * 3)
+                    : color(0, (pos - 170) * 3, 255 - (pos - 170) * 3);
+}
+
+constexpr uint8_t WHEEL_SIZE = 32;
+constexpr uint8_t BREATHE_SIZE = 8;
+
+// palette indices
+constexpr uint8_t WHEEL = 0;
+constexpr uint8_t OFF = WHEEL + WHEEL_SIZE;
+constexpr uint8_t RED = OFF + 1;
+constexpr uint8_t BLUE = RED + 1;
+constexpr uint8_t CHARGE = BLUE + 1;  // one per bar count 1 .. 5
+constexpr uint8_t BREATHE = CHARGE + NUM_PIXEL;  // rising blue
+constexpr uint8_t SIZE = BREATHE + BREATHE_SIZE;
+
+// all colors shown, gamma corrected at compile time
+const uint32_t PALETTE[SIZE] PROGMEM = {
+    wheel(0), wheel(8), wheel(16), wheel(24), wheel(32), wheel(40), wheel(48), wheel(56),
+    wheel(64), wheel(72), wheel(80), wheel(88), wheel(96), wheel(104), wheel(112), wheel(120),
+    wheel(128), wheel(136), wheel(144), wheel(152), wheel(160), wheel(168), wheel(176), wheel(184),
+    wheel(192), wheel(200), wheel(208), wheel(216), wheel(224), wheel(232), wheel(240), wheel(248),
+    0, color(0xff, 0x00, 0x00), color(0x00, 0x00, 0xff),
+    color(0xff, 0x00, 0x33), color(0xc7, 0x5f, 0x00), color(0x7b, 0x7e, 0x00), color(0x00, 0x8b, 0x00),
+    color(0x00, 0x8b, 0x00),
+    color(0, 0, 31), color(0, 0, 63), color(0, 0, 95), color(0, 0, 127), color(0, 0, 159), color(0, 0, 191),
+    color(0, 0, 223), color(0, 0, 255)
+};
+
+}  // namespace led_palette
+
+enum class LedEffect : uint8_t
+{
+    Rainbow,  // starting up
+    Bars,  // value: number of red bars (tuning)
+    Charge,  // value: battery charge [%]
+    LowBattery,  // value: battery charge [%]; blinking charge bars
+    Calibrating,  // breathing blue
+    FailSafe  // blinking red
+};
+
+/**
+ * LED effect engine
+ *
+ * Each frame is rendered as palette indices, a few table lookups per pixel, and only pixels whose index changed are
+ * written. The strip is refreshed (which blocks interrupts) only when a pixel changed. All colors come from a
+ * gamma corrected palette in flash, so no color math runs on the target. Call update() once per frame; animations
+ * advance by one step per call, so their speed is set by the caller's task period.
+ */
 class LedGauge
 {
 public:
     LedGauge(uint8_t pin)
         : _pixels(NUM_PIXEL, pin, NEO_GRB + NEO_KHZ800)
-    {}
+    {
+        invalidate();
+    }
 
     void setup() { _pixels.begin(); }
 
     bool canShow() { return _pixels.canShow(); }
 
-    void rainbowCycle(int speedDelayMs)
+    /**
+     * Render and show the next frame of \p effect
+     *
+     * @param effect Effect, restarts its animation when changed
+     * @param value Effect parameter
+     */
+    void update(LedEffect effect, int16_t value = 0)
     {
         if (!canShow())
             return;
 
-        if (Timer::instance().get_count() - prevTimer > static_cast<uint16_t>(COUNT_PER_MICROS * speedDelayMs))
+        if (effect != _effect)
         {
-            auto c = wheelColor(((_rbState.pixel * 256 / NUM_PIXEL) + _rbState.phase) & 255);
-            _pixels.setPixelColor(_rbState.pixel, c);
-
-            if (++_rbState.pixel == NUM_PIXEL)
-            {
-                show();
-                _rbState.pixel = 0;
-
-                if (++_rbState.phase == 256 * 5)
-                {
-                    _rbState.phase = 0;
-                }
-            }
+            _effect = effect;
+            _phase = 0;
         }
-    }
 
-    void showBars(int bars, int speedDelayMs = 1)
-    {
-        if (!canShow())
-            return;
+        uint8_t frame[NUM_PIXEL];
+        render(frame, value);
+        ++_phase;
 
-        if (Timer::instance().get_count() - prevTimer > static_cast<uint16_t>(COUNT_PER_MICROS * speedDelayMs))
+        bool changed = false;
+        for (uint8_t i = 0; i < NUM_PIXEL; ++i)
         {
-            _lastBars = bars;
-
-            uint32_t colors[5];
-            for (int i = 0; i < 5; ++i)
+            if (frame[i] != _shown[i])
             {
-                colors[i] = Adafruit_NeoPixel::Color(0x00, 0x00, 0xff);
-            }
-
-            for (int i = 0; i < bars; ++i)
-            {
-                colors[i] = Adafruit_NeoPixel::Color(0xff, 0x00, 0x00);
-            }
-
-            for (int i = 0; i < 5; ++i)
-            {
-                setPixelColor(i, colors[i]);
+                _shown[i] = frame[i];
+                _pixels.setPixelColor(i, pgm_read_dword(&led_palette::PALETTE[frame[i]]));
+                changed = true;
             }
+        }
 
+        if (changed)
+        {
             show();
         }
     }
 
-    void showVoltage(float voltage, int speedDelayMs = 1)
+    /**
+     * Render the current frame of the selected effect
+     *
+     * @param frame Palette index per pixel
+     * @param value Effect parameter
+     */
+    void render(uint8_t (&frame)[NUM_PIXEL], int16_t value)
     {
-        static const estd::array<float, 6> VOLTAGE_LEVELS = { 0.0f, 7.45f, 7.59f, 7.75f, 8.16f, 999.0f };
-        static const estd::array<uint32_t, 5> COLORS = {
-            Adafruit_NeoPixel::Color(255, 0, 51), Adafruit_NeoPixel::Color(0xc7, 0x5f, 0x00),
-            Adafruit_NeoPixel::Color(0x7b, 0x7e, 0x00), Adafruit_NeoPixel::Color(0x00, 0x8b, 0x00), 
-            Adafruit_NeoPixel::Color(0x00, 0x8b, 0x00)
-        };
-        static constexpr float MARGIN = 0.1f;
+        using namespace led_palette;
 
-        if (!canShow())
-            return;
-
-        if (Timer::instance().get_count() - prevTimer < static_cast<uint16_t>(COUNT_PER_MICROS * speedDelayMs))
-            return;
+        // blink at 16 frames on, 16 off
+        bool blink_on = (_phase & 0x10) == 0;
 
-        // get bounds of current level
-        auto lower_bound = VOLTAGE_LEVELS[estd::clamp(_lastBars - 1, 0, VOLTAGE_LEVELS.size()-1)];
-        auto upper_bound = VOLTAGE_LEVELS[estd::clamp(_lastBars, 0, VOLTAGE_LEVELS.size()-1)] + MARGIN;
-
-        int bars = _lastBars;
-        if (m_forceRefresh || voltage < lower_bound || voltage > upper_bound)
+        switch (_effect)
         {
-            bars = 0;
-            for (auto level : VOLTAGE_LEVELS)
+        case LedEffect::Rainbow:
+            for (uint8_t i = 0; i < NUM_PIXEL; ++i)
             {
-                if (voltage < level)
-                    break;
-
-                ++bars;
+                frame[i] = WHEEL + (((_phase >> 1) + (i * WHEEL_SIZE) / NUM_PIXEL) & (WHEEL_SIZE - 1));
             }
-        }
-
-        if (bars != _lastBars || m_forceRefresh)
-        {
-            auto color = COLORS[bars-1];
-            _lastBars = bars;
+            break;
 
-            uint32_t colors[5];
-            for (int i = 0; i < 5; ++i)
+        case LedEffect::Bars:
+            for (int16_t i = 0; i < NUM_PIXEL; ++i)
             {
-                colors[i] = 0;
+                frame[i] = i < value ? RED : BLUE;
             }
+            break;
 
-            for (int i = 0; i < bars; ++i)
+        case LedEffect::Charge:
+        case LedEffect::LowBattery:
             {
-                colors[i] = color;
+                uint8_t bars = chargeBars(value);
+                uint8_t on = (_effect == LedEffect::Charge || blink_on) ? CHARGE + bars - 1 : OFF;
+                for (uint8_t i = 0; i < NUM_PIXEL; ++i)
+                {
+                    frame[i] = i < bars ? on : OFF;
+                }
             }
+            break;
 
-            for (int i = 0; i < 5; ++i)
+        case LedEffect::Calibrating:
             {
-                setPixelColor(i, colors[i]);
+                // triangle wave over the ramp, two frames per step
+                uint8_t step = (_phase >> 1) & (2 * BREATHE_SIZE - 1);
+                uint8_t level = step < BREATHE_SIZE ? step : 2 * BREATHE_SIZE - 1 - step;
+                for (uint8_t i = 0; i < NUM_PIXEL; ++i)
+                {
+                    frame[i] = BREATHE + level;
+                }
             }
+            break;
 
-            show();
-            m_forceRefresh = false;
+        case LedEffect::FailSafe:
+            for (uint8_t i = 0; i < NUM_PIXEL; ++i)
+            {
+                frame[i] = blink_on ? RED : OFF;
+            }
+            break;
         }
     }
 
 private:
-    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+    /**
+     * Number of bars (1..5) for the battery charge, with hysteresis against flicker at the thresholds
+     *
+     * @param percent Remaining charge [%]
+     */
+    uint8_t chargeBars(int16_t percent)
     {
-        _pixels.setPixelColor(n, 
-            Adafruit_NeoPixel::gamma8(r), 
-            Adafruit_NeoPixel::gamma8(g),
-            Adafruit_NeoPixel::gamma8(b));
+        // lowest charge for each bar count; thresholds match the former 2S voltage levels 7.45, 7.59, 7.75 and
+        // 8.16 V at rest
+        static const int16_t CHARGE_LEVELS[NUM_PIXEL] PROGMEM = {0, 20, 40, 60, 90};
+        static constexpr int16_t MARGIN = 2;
+
+        while (_bars < NUM_PIXEL && percent >= static_cast<int16_t>(pgm_read_word(&CHARGE_LEVELS[_bars])) + MARGIN)
+        {
+            ++_bars;
+        }
+
+        while (_bars > 1 && percent < static_cast<int16_t>(pgm_read_word(&CHARGE_LEVELS[_bars - 1])))
+        {
+            --_bars;
+        }
+
+        return _bars;
     }
 
-    void setPixelColor(uint16_t n, uint32_t color)
+    // force a full refresh with the next frame
+    void invalidate()
     {
-        _pixels.setPixelColor(n, Adafruit_NeoPixel::gamma32(color));
+        for (uint8_t i = 0; i < NUM_PIXEL; ++i)
+        {
+            _shown[i] = 0xff;
+        }
     }
 
     void show()
     {
-        prevTimer = Timer::instance().get_count();
         _pixels.show();
-        m_forceRefresh = true;
         Timer::instance().bump(NUM_PIXEL * 30 * COUNT_PER_MICROS);
     }
 
-    struct RainBowState
-    {
-        uint16_t pixel = 0;
-        uint16_t phase = 0;
-    };
-
-    uint32_t wheelColor(byte wheelPos)
-    {
-        if (wheelPos < 85)
-            return Adafruit_NeoPixel::Color(wheelPos * 3, 255 - wheelPos * 3, 0);
-        else if (wheelPos < 170)
-        {
-            wheelPos -= 85;
-            return Adafruit_NeoPixel::Color(255 - wheelPos * 3, 0, wheelPos * 3);
-        }
-        else
-        {
-            wheelPos -= 170;
-            return Adafruit_NeoPixel::Color(0, wheelPos * 3, 255 - wheelPos * 3);
-        }
-    }
-
 private:
     Adafruit_NeoPixel _pixels;
-    RainBowState _rbState;
-    uint32_t prevTimer = 0;
-    float _lastVoltage = -1.0;
-    int _lastBars = 1;
-    uint8_t _glow = 0;
-    bool m_forceRefresh = true;
+    uint8_t _shown[NUM_PIXEL];  // palette index per pixel
+    LedEffect _effect = LedEffect::Rainbow;
+    uint8_t _phase = 0;
+    uint8_t _bars = 1;
 };
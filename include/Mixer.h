@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Arduino.h>
+
+// control inputs of the mixer, offsets from neutral [us]
+struct MixerInput
+{
+    int16_t thrust;  // forward positive
+    int16_t yaw;  // counter-clockwise positive
+    int16_t hover;  // lift above the hover fan zero
+};
+
+/**
+ * One output of the mixer: weighted sum of the inputs plus trim, within limits
+ *
+ * Weights are Q6 (64 = 1.0, -64 = inverted); powers of two fold into shifts.
+ */
+struct MixerRow
+{
+    int8_t thrust;
+    int8_t yaw;
+    int8_t hover;
+    int16_t trim;  // output at neutral input [us]
+    int16_t min_us;
+    int16_t max_us;
+};
+
+/**
+ * Mixer matrix mapping the control inputs to N actuator outputs, fixed at compile time
+ *
+ * The rows are a constexpr array and the output index a template argument, so each output reduces to the adds and
+ * shifts of its non-zero weights. A rudder servo is one more row, e.g. {0, 64, 0, 1500, 1100, 1900}; a four-fan
+ * layout two more fan rows (raise MAX_PWM_COUNT for the additional RcPwm channels).
+ *
+ * Nonlinear per-output stages (e.g. thrust curves) go between mix() and output().
+ *
+ * @tparam OUTPUTS Number of outputs
+ * @tparam ROWS Mixer rows, one per output
+ */
+template <uint8_t OUTPUTS, const MixerRow (&ROWS)[OUTPUTS]>
+class Mixer
+{
+public:
+    static constexpr uint8_t WEIGHT_SHIFT = 6;
+
+    /**
+     * Weighted sum of the inputs for output \p I
+     *
+     * @return int16_t Offset from the output trim [us]
+     */
+    template <uint8_t I>
+    static constexpr int16_t mix(const MixerInput& in)
+    {
+        static_assert(I < OUTPUTS, "mixer output out of range");
+        return static_cast<int16_t>((static_cast<int32_t>(in.thrust) * ROWS[I].thrust +
+                                        static_cast<int32_t>(in.yaw) * ROWS[I].yaw +
+                                        static_cast<int32_t>(in.hover) * ROWS[I].hover) >>
+            WEIGHT_SHIFT);
+    }
+
+    /**
+     * Value of output \p I for the given offset
+     *
+     * @param offset Offset from the trim [us], usually from mix()
+     * @return int16_t Output value within the row limits [us]
+     */
+    template <uint8_t I>
+    static constexpr int16_t output(int16_t offset)
+    {
+        return ROWS[I].trim + offset < ROWS[I].min_us
+            ? ROWS[I].min_us
+            : (ROWS[I].trim + offset > ROWS[I].max_us ? ROWS[I].max_us : ROWS[I].trim + offset);
+    }
+
+    // output value at neutral input [us]
+    template <uint8_t I>
+    static constexpr int16_t trim()
+    {
+        return ROWS[I].trim;
+    }
+};
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Profile.h"
 #include "RcPwm.h"
+#include "Tachometer.h"
 #include <Arduino.h>
 #include <assert.h>
 #include <estd/algorithm.h>
@@ -31,8 +33,52 @@ public:
     void disable() { _disabled = true; }
     void enable() { _disabled = false; }
 
+    // attach speed feedback for setRpm()
+    void setTachometer(const Tachometer* tachometer) { _tachometer = tachometer; }
+
+    // measured speed [1/min], 0 without tachometer
+    uint16_t rpm() const { return _tachometer ? _tachometer->rpm() : 0; }
+
+    /**
+     * Closed-loop speed: the open-loop command is corrected by an integral trim from the speed error
+     *
+     * Without a running tachometer, or for a zero target, the trim is reset and \p value_us is used as is. The trim
+     * may bring the command down to \p midValue but never across it, so a fan is never reversed.
+     *
+     * @param target_rpm Speed set-point [1/min]
+     * @param value_us Open-loop (feed-forward) command [us]
+     * @param midValue Zero-thrust command [us]; the trim acts away from it in either direction
+     * @param maxStep Maximum step, see setFiltered()
+     */
+    void setRpm(uint16_t target_rpm, uint16_t value_us, uint16_t midValue, uint16_t maxStep)
+    {
+        if (_tachometer && _tachometer->running() && target_rpm != 0)
+        {
+            int16_t error = estd::clamp(static_cast<int32_t>(target_rpm) - _tachometer->rpm(),
+                static_cast<int32_t>(-RPM_ERROR_LIMIT), static_cast<int32_t>(RPM_ERROR_LIMIT));
+            _rpm_trim_q4 = estd::clamp(static_cast<int16_t>(_rpm_trim_q4 + error / RPM_TRIM_DIVISOR),
+                static_cast<int16_t>(-RPM_TRIM_LIMIT_Q4), static_cast<int16_t>(RPM_TRIM_LIMIT_Q4));
+
+            int16_t trim = _rpm_trim_q4 / 16;
+            int16_t mid = static_cast<int16_t>(midValue);
+            value_us = value_us >= midValue ? estd::max(static_cast<int16_t>(value_us + trim), mid)
+                                            : estd::min(static_cast<int16_t>(value_us - trim), mid);
+        }
+        else
+        {
+            _rpm_trim_q4 = 0;
+        }
+
+        setFiltered(value_us, midValue, maxStep);
+    }
+
+    // present speed trim [us]
+    int16_t rpmTrim() const { return _rpm_trim_q4 / 16; }
+
     void setFiltered(uint16_t value_us, uint16_t midValue, uint16_t maxStep, bool clamp = true)
     {
+        PROFILE(MotorFilter);
+
         if (value_us > midValue && value_us > _value_us && (value_us - _value_us) > maxStep)
         {
             value_us = _value_us + maxStep;
@@ -60,6 +106,12 @@ public:
         }
     }
 
+private:
+    // speed trim: 1/16 us per frame for every RPM_TRIM_DIVISOR rpm of error, at most 50 us
+    static constexpr int16_t RPM_TRIM_DIVISOR = 64;
+    static constexpr int16_t RPM_ERROR_LIMIT = 8000;
+    static constexpr int16_t RPM_TRIM_LIMIT_Q4 = 50 * 16;
+
 private:
     uint16_t _disabled;
     const int _pin;
@@ -67,4 +119,6 @@ private:
     RcPwm _pwm;
     uint16_t _value_us;
     uint32_t _start_time;
+    const Tachometer* _tachometer = nullptr;
+    int16_t _rpm_trim_q4 = 0;  // [us / 16]
 };
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Pin change interrupt dispatcher for all three ports (PCINT0: D8-D13, PCINT1: A0-A5, PCINT2: D0-D7)
+ *
+ * Each port keeps its last input value. An interrupt XORs the new value against it once and calls the handler
+ * registered for each changed bit through a bit-to-handler table, so the work per edge does not depend on how many
+ * pins are attached. All handlers of one interrupt see the same timestamp.
+ */
+class PinChange
+{
+public:
+    static constexpr uint8_t PORT_COUNT = 3;
+
+    /**
+     * Edge handler; called from the ISR
+     *
+     * @param high New pin level
+     * @param now Time of the interrupt [timer counts]
+     */
+    typedef void (*Handler)(bool high, uint32_t now);
+
+    /**
+     * Register \p handler for \p pin and enable its pin change interrupt
+     *
+     * @param handler Called by dispatch(); \c nullptr for pins whose ISR reads them with rising()
+     */
+    static void attach(uint8_t pin, Handler handler = nullptr);
+
+    /**
+     * Call the handlers of the pins of \p port that changed since the last call
+     *
+     * Called from ISR(PCINT0_vect) .. ISR(PCINT2_vect), which the application defines for the ports it uses.
+     *
+     * @param port Port index (PCICR bit)
+     * @param pins Port input value
+     * @param now Current time [timer counts]
+     */
+    static void dispatch(uint8_t port, uint8_t pins, uint32_t now) __attribute__((always_inline))
+    {
+        uint8_t changed = (pins ^ _prev[port]) & _enabled[port];
+        _prev[port] = pins;
+
+        const Handler* handler = _handlers[port];
+        for (uint8_t mask = 1; changed != 0; mask <<= 1, ++handler)
+        {
+            if (changed & mask)
+            {
+                changed &= ~mask;
+                (*handler)((pins & mask) != 0, now);
+            }
+        }
+    }
+
+    /**
+     * Rising edges of the attached pins of \p port since the last call
+     *
+     * For frequency inputs, whose ISR handles the pins inline instead of dispatch(): the interrupt fires on both
+     * edges, and this level check lets it return on the falling ones before reading the time. Not for ports that
+     * use dispatch().
+     *
+     * @param port Port index (PCICR bit)
+     * @param pins Port input value
+     * @return uint8_t Mask of the pins that went high
+     */
+    static uint8_t rising(uint8_t port, uint8_t pins) __attribute__((always_inline))
+    {
+        uint8_t rising = pins & ~_prev[port] & _enabled[port];
+        _prev[port] = pins;
+        return rising;
+    }
+
+private:
+    static Handler _handlers[PORT_COUNT][8];
+    static uint8_t _enabled[PORT_COUNT];
+    static uint8_t _prev[PORT_COUNT];
+};
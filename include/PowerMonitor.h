@@ -0,0 +1,204 @@
+#pragma once
+
+#include "Timer.h"
+#include <Arduino.h>
+#include <Wire.h>
+
+/**
+ * INA219 bus voltage, shunt current and power monitor
+ *
+ * The device runs in triggered mode: a conversion is started after each read, and the next read only happens once
+ * the configured conversion time has elapsed and the device flags the conversion as ready. Readings therefore never
+ * come from a stale register. A lost trigger (failed configuration write) or a conversion that never completes is
+ * restarted once it is overdue, so the readings resume after a bus error.
+ */
+class PowerMonitor
+{
+public:
+    // ADC setting for bus and shunt conversions (BADC/SADC register fields)
+    enum class Adc : uint8_t
+    {
+        Bits9 = 0x0,  // 84 us
+        Bits10 = 0x1,  // 148 us
+        Bits11 = 0x2,  // 276 us
+        Bits12 = 0x3,  // 532 us
+        Avg2 = 0x9,  // 1.06 ms
+        Avg4 = 0xa,  // 2.13 ms
+        Avg8 = 0xb,  // 4.26 ms
+        Avg16 = 0xc,  // 8.51 ms
+        Avg32 = 0xd,  // 17.02 ms
+        Avg64 = 0xe,  // 34.05 ms
+        Avg128 = 0xf  // 68.10 ms
+    };
+
+    /**
+     * @param address I2C address
+     * @param shunt_mohm Shunt resistance [mOhm]
+     */
+    PowerMonitor(uint8_t address, uint16_t shunt_mohm)
+        : _address(address)
+        , _calibration(static_cast<uint16_t>(40960UL / shunt_mohm))  // current LSB of 1 mA
+    {}
+
+    void setup(Adc bus_adc = Adc::Avg4, Adc shunt_adc = Adc::Avg16)
+    {
+        Wire.begin();
+        configure(bus_adc, shunt_adc);
+    }
+
+    /**
+     * Set averaging / resolution and restart conversion
+     */
+    void configure(Adc bus_adc, Adc shunt_adc)
+    {
+        // 32 V bus range, +/- 320 mV shunt range, shunt and bus triggered
+        _config = CONFIG_BRNG_32V | CONFIG_PGA_320MV | (static_cast<uint16_t>(bus_adc) << 7) |
+            (static_cast<uint16_t>(shunt_adc) << 3) | MODE_TRIGGERED;
+        _conversion_count = (conversionTimeUs(bus_adc) + conversionTimeUs(shunt_adc)) * COUNT_PER_MICROS;
+
+        writeRegister(REG_CALIBRATION, _calibration);
+        trigger(Timer::instance().get_count());
+    }
+
+    /**
+     * Read a new sample if a conversion has completed since the last one
+     *
+     * @param now Timer count
+     * @return \c true if voltage, current and power were updated
+     */
+    bool poll(uint32_t now)
+    {
+        if (now - _trigger_count < _conversion_count)
+            return false;
+
+        uint16_t bus;
+        if (!readRegister(REG_BUS_VOLTAGE, bus))
+            return false;
+
+        if ((bus & BUS_CNVR) == 0)
+        {
+            // no conversion running: the trigger was lost
+            if (now - _trigger_count >= OVERDUE_FACTOR * _conversion_count)
+            {
+                if (_retriggers < 0xffff)
+                {
+                    ++_retriggers;
+                }
+                trigger(now);
+            }
+            return false;
+        }
+
+        uint16_t current, power;
+        if (!readRegister(REG_CURRENT, current) || !readRegister(REG_POWER, power))
+            return false;
+
+        _voltage_mv = static_cast<int16_t>((bus >> 3) * 4);
+        _current_ma = static_cast<int16_t>(current);
+        _power_mw = power * 20UL;
+
+        // integrate charge [mA * 8 us], using the time between conversion starts
+        uint32_t dt = now - _trigger_count;
+        if (dt > MAX_INTEGRATION_COUNT)
+        {
+            dt = MAX_INTEGRATION_COUNT;
+        }
+
+        if (_current_ma > 0)
+        {
+            _charge_acc += static_cast<uint32_t>(_current_ma) * (dt >> INTEGRATION_SHIFT);
+            _consumed_mah += _charge_acc / CHARGE_PER_MAH;
+            _charge_acc %= CHARGE_PER_MAH;
+        }
+
+        trigger(now);
+        return true;
+    }
+
+    // bus voltage [mV]
+    int16_t voltage() const { return _voltage_mv; }
+
+    // shunt current [mA]
+    int16_t current() const { return _current_ma; }
+
+    // power [mW]
+    uint32_t power() const { return _power_mw; }
+
+    // charge consumed since power-up [mAh]
+    uint16_t consumed() const { return _consumed_mah; }
+
+    // conversions restarted after a lost trigger (saturating)
+    uint16_t retriggers() const { return _retriggers; }
+
+private:
+    static constexpr uint8_t REG_CONFIG = 0x00;
+    static constexpr uint8_t REG_BUS_VOLTAGE = 0x02;
+    static constexpr uint8_t REG_POWER = 0x03;
+    static constexpr uint8_t REG_CURRENT = 0x04;
+    static constexpr uint8_t REG_CALIBRATION = 0x05;
+
+    static constexpr uint16_t CONFIG_BRNG_32V = 0x2000;
+    static constexpr uint16_t CONFIG_PGA_320MV = 0x1800;
+    static constexpr uint16_t MODE_TRIGGERED = 0x0003;
+    static constexpr uint16_t BUS_CNVR = 0x0002;
+
+    // a conversion not ready after this many conversion times was never started
+    static constexpr uint8_t OVERDUE_FACTOR = 2;
+
+    // charge integration in 8 us steps (16 Timer counts), at most 100 ms per sample
+    static constexpr uint8_t INTEGRATION_SHIFT = 4;
+    static constexpr uint32_t CHARGE_PER_MAH = 3600UL * 1000000UL / 8;
+    static constexpr uint32_t MAX_INTEGRATION_COUNT = 100000UL * COUNT_PER_MICROS;
+
+    static uint32_t conversionTimeUs(Adc adc)
+    {
+        static const uint16_t RESOLUTION_US[] = { 84, 148, 276, 532 };
+
+        auto value = static_cast<uint8_t>(adc);
+        return (value & 0x8) ? (532UL << (value & 0x7)) : RESOLUTION_US[value & 0x3];
+    }
+
+    void trigger(uint32_t now)
+    {
+        // writing the configuration starts a new conversion and clears the conversion ready flag; after a failed
+        // write the trigger time stays, so poll() finds the conversion overdue and tries again
+        if (writeRegister(REG_CONFIG, _config))
+        {
+            _trigger_count = now;
+        }
+    }
+
+    bool writeRegister(uint8_t reg, uint16_t value)
+    {
+        Wire.beginTransmission(_address);
+        Wire.write(reg);
+        Wire.write(static_cast<uint8_t>(value >> 8));
+        Wire.write(static_cast<uint8_t>(value & 0xff));
+        return Wire.endTransmission() == 0;
+    }
+
+    bool readRegister(uint8_t reg, uint16_t& value)
+    {
+        Wire.beginTransmission(_address);
+        Wire.write(reg);
+        if (Wire.endTransmission() != 0 || Wire.requestFrom(_address, static_cast<uint8_t>(2)) != 2)
+            return false;
+
+        value = static_cast<uint16_t>(Wire.read()) << 8;
+        value |= static_cast<uint16_t>(Wire.read());
+        return true;
+    }
+
+private:
+    const uint8_t _address;
+    const uint16_t _calibration;
+    uint16_t _config = 0;
+    uint32_t _conversion_count = 0;
+    uint32_t _trigger_count = 0;
+    int16_t _voltage_mv = 0;
+    int16_t _current_ma = 0;
+    uint32_t _power_mw = 0;
+    uint32_t _charge_acc = 0;
+    uint16_t _consumed_mah = 0;
+    uint16_t _retriggers = 0;
+};
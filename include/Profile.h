@@ -0,0 +1,163 @@
+#pragma once
+
+/**
+ * On-target execution time profiling of the hot paths
+ *
+ * Built only with -DHOVER_PROFILE (see the "profile" environment in platformio.ini); otherwise PROFILE() expands to
+ * nothing. Each PROFILE(point) measures its enclosing scope with the Timer count (0.5 us resolution) and keeps
+ * count, sum and maximum per point. report() prints one point per call as
+ *
+ *     PRF <name> <count> <mean us> <max us>
+ *
+ * with times to 0.1 us (e.g. "12.5"), which tools/profile_check.py compares against a recorded baseline.
+ */
+
+#include "Timer.h"
+#include <Arduino.h>
+
+enum class ProfilePoint : uint8_t
+{
+    RcRx,  // pin change ISR incl. RcChannel::rx()
+    PwmRun,  // RcPwm::runImpl()
+    PwmWrite,  // RcPwm::writeMicroseconds()
+    Damping,  // calculate_damping_factor()
+    Hover,  // handle_hover_state()
+    StateMachine,  // update_state_machine()
+    MotorFilter,  // Motor::setFiltered()
+    Gauge,  // LED gauge update
+    Count
+};
+
+#ifdef HOVER_PROFILE
+
+class Profile
+{
+public:
+    class Scope
+    {
+    public:
+        explicit Scope(ProfilePoint point)
+            : _point(point)
+            , _start(Timer::instance().get_count())
+        {}
+
+        ~Scope() { record(_point, Timer::instance().get_count() - _start); }
+
+    private:
+        const ProfilePoint _point;
+        const uint32_t _start;
+    };
+
+    static void record(ProfilePoint point, uint32_t counts)
+    {
+        uint8_t SREG_old = SREG;
+        noInterrupts();
+
+        Entry& e = entries()[static_cast<uint8_t>(point)];
+        if (e.count < 0xffff)
+        {
+            ++e.count;
+            e.sum += counts;
+        }
+        if (counts > e.max)
+        {
+            e.max = counts;
+        }
+
+        SREG = SREG_old;
+    }
+
+    /**
+     * Print the next point and reset it
+     *
+     * The first line of each round reports Timer::get_count() itself (two back-to-back calls), which is also the
+     * measurement overhead included in every other point.
+     *
+     * @param out Output stream
+     */
+    static void report(Print& out)
+    {
+        static uint8_t next = 0;
+
+        if (next == 0)
+        {
+            uint32_t a = Timer::instance().get_count();
+            uint32_t b = Timer::instance().get_count();
+            print(out, "TimerCount", 1, b - a, b - a);
+        }
+        else
+        {
+            uint8_t SREG_old = SREG;
+            noInterrupts();
+            Entry e = entries()[next - 1];
+            entries()[next - 1] = Entry();
+            SREG = SREG_old;
+
+            print(out, name(next - 1), e.count, e.sum, e.max);
+        }
+
+        if (++next > static_cast<uint8_t>(ProfilePoint::Count))
+        {
+            next = 0;
+        }
+    }
+
+private:
+    struct Entry
+    {
+        uint16_t count = 0;
+        uint32_t sum = 0;  // [timer counts]
+        uint32_t max = 0;  // [timer counts]
+    };
+
+    static const char* name(uint8_t point)
+    {
+        static const char* const NAMES[] = {
+            "RcRx", "PwmRun", "PwmWrite", "Damping", "Hover", "StateMachine", "MotorFilter", "Gauge"
+        };
+        static_assert(sizeof(NAMES) / sizeof(NAMES[0]) == static_cast<uint8_t>(ProfilePoint::Count), "missing name");
+
+        return NAMES[point];
+    }
+
+    // function-local so that all translation units share one table
+    static Entry* entries()
+    {
+        static Entry e[static_cast<uint8_t>(ProfilePoint::Count)];
+        return e;
+    }
+
+    static void print(Print& out, const char* name, uint16_t count, uint32_t sum, uint32_t max)
+    {
+        out.print("PRF ");
+        out.print(name);
+        out.print(' ');
+        out.print(count);
+        out.print(' ');
+        printMicros(out, count != 0 ? (sum * TENTHS_PER_COUNT + count / 2) / count : 0);
+        out.print(' ');
+        printMicros(out, max * TENTHS_PER_COUNT);
+        out.println();
+    }
+
+    // Timer counts are 0.5 us, i.e. 5 tenths of a microsecond
+    static constexpr uint8_t TENTHS_PER_COUNT = 10 / COUNT_PER_MICROS;
+
+    // \p tenths [0.1 us] as microseconds with one decimal
+    static void printMicros(Print& out, uint32_t tenths)
+    {
+        out.print(tenths / 10);
+        out.print('.');
+        out.print(static_cast<uint8_t>(tenths % 10));
+    }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE(point) Profile::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(ProfilePoint::point)
+
+#else
+
+#define PROFILE(point)
+
+#endif
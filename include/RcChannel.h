@@ -1,69 +1,231 @@
 #pragma once
+#include "PinChange.h"
+#include "Timer.h"
 #include <Arduino.h>
+#include <estd/algorithm.h>
 
 class RcChannel
 {
 public:
-    static constexpr auto AVG_CNT = 4;
+    // number of pulses the median is taken over (3 or 5); adds (FILTER_LEN - 1) / 2 frames of latency on steps
+    static constexpr uint8_t FILTER_LEN = 3;
 
-    RcChannel(uint8_t pin, uint32_t init_pulse_length)
+    // valid pulse lengths [timer counts]
+    static constexpr uint16_t MIN_PULSE = 800 * COUNT_PER_MICROS;
+    static constexpr uint16_t MAX_PULSE = 2200 * COUNT_PER_MICROS;
+
+    // shortest accepted interval between rising edges (receivers send at 50 .. 250 Hz) [timer counts]
+    static constexpr uint16_t MIN_PERIOD = 3000 * COUNT_PER_MICROS;
+
+    RcChannel(uint8_t pin, uint16_t init_pulse_length)
         : _pin(pin)
-        , _mask(bit(pin))
-        , _start(0)
-        , _pulse_length(init_pulse_length)
-        , _prev_pind(PIND)
+        , _started(false)
+        , _has_prev_start(false)
+        , _fresh(false)
     {
+        for (uint8_t i = 0; i < FILTER_LEN; ++i)
+        {
+            _history[i] = init_pulse_length;
+        }
     }
 
-    void setup() { pci_setup(_pin); }
+    /**
+     * Enable edge detection
+     *
+     * @param handler Pin change handler forwarding the edges to rx()
+     */
+    void setup(PinChange::Handler handler) { PinChange::attach(_pin, handler); }
+
+    /**
+     * Pulse length, median of the last FILTER_LEN valid pulses
+     *
+     * Computed on demand in the main loop, so the ISR only stores the raw pulse; a single corrupted pulse never
+     * reaches the output.
+     *
+     * @return uint16_t Pulse length [timer counts]
+     */
+    uint16_t pulse_length() const { return median(_history); }
+
+    /**
+     * Check whether a valid pulse was received recently
+     *
+     * @param now Current time [timer counts]
+     * @param timeout Maximum age of last valid pulse [timer counts]
+     * @return \c true if the last valid pulse was seen less than \p timeout ago
+     */
+    bool valid(uint32_t now, uint32_t timeout) const { return _last_valid != 0 && now - _last_valid < timeout; }
 
-    // pulse length in us
-    uint32_t pulse_length() const { return _pulse_length; }
+    // number of rejected pulses (saturating)
+    uint8_t glitches() const { return _glitches; }
 
     /**
-     * Handle RC channel pin change
-     * 
-     * @param pind Value of PIND
-     * @param us Current time [us]
-     * @return \c true on detected falling edge (end of RC channel signal)
+     * Take the pulse received since the last call; ISR only
+     *
+     * @param pulse Last valid pulse length [timer counts]
+     * @return \c true if a new valid pulse was received since the last call
+     */
+    bool take(uint16_t& pulse)
+    {
+        pulse = _pulse;
+        bool fresh = _fresh;
+        _fresh = false;
+        return fresh;
+    }
+
+    /**
+     * Feed a pulse from a frame snapshot into the filter; main loop only
+     *
+     * @param pulse Pulse length [timer counts]
+     * @param fresh \c true if the pulse is new in this frame
+     * @param now Current time [timer counts]
+     */
+    void update(uint16_t pulse, bool fresh, uint32_t now)
+    {
+        if (!fresh)
+            return;
+
+        _history[_head] = pulse;
+        if (++_head == FILTER_LEN)
+        {
+            _head = 0;
+        }
+        _last_valid = now;
+    }
+
+    /**
+     * Forget the last pulse start once the period check is over; main loop only, at least every 29 ms
+     *
+     * The start time is the low 16 bits of the Timer count, which wrap every 32.8 ms. Without this, a rising edge
+     * after a gap of 32.8 .. 35.8 ms would look like noise, and the falling edge of a pulse started more than 32.8 ms
+     * earlier like a valid pulse.
+     *
+     * @param now Current time [timer counts]
      */
-    bool rx(uint8_t pind, uint32_t us) __attribute__((always_inline))
+    void expire(uint32_t now)
     {
-        bool falling = false;
+        uint8_t SREG_old = SREG;
+        noInterrupts();
 
-        if ((pind ^ _prev_pind) & _mask)
+        if (_has_prev_start && static_cast<uint16_t>(now - _start) >= MIN_PERIOD)
         {
-            if ((pind & _mask) != 0)
+            if (_started)
             {
-                // rising
-                _start = us;
+                // longer than any valid pulse
+                _started = false;
+                glitch();
             }
-            else if (_start != 0)
+            _has_prev_start = false;
+        }
+
+        SREG = SREG_old;
+    }
+
+    /**
+     * Handle RC channel pin change; ISR only
+     *
+     * Intervals are 16-bit differences, exact for pulses and the minimum period; expire() covers longer gaps.
+     *
+     * @param high New pin level
+     * @param now Current time [timer counts, low 16 bits]
+     * @return \c true on detected falling edge (end of RC channel signal)
+     */
+    bool rx(bool high, uint16_t now) __attribute__((always_inline))
+    {
+        if (high)
+        {
+            uint16_t since_start = now - _start;
+            if (_started && since_start < MIN_PERIOD)
+            {
+                // late rising edge of a pulse already begun by start()
+            }
+            else if (!_has_prev_start || since_start >= MIN_PERIOD)
+            {
+                start(now);
+            }
+            else
             {
-                // falling
-                _pulse_length = us - _start;
-                _start = 0;
-                falling = true;
+                // edges arriving faster than any receiver frame rate are noise
+                glitch();
             }
 
-            _prev_pind = pind;
+            return false;
+        }
+
+        if (!_started)
+            return false;
+
+        uint16_t length = now - _start;
+        _started = false;
+
+        if (length >= MIN_PULSE && length <= MAX_PULSE)
+        {
+            _pulse = length;
+            _fresh = true;
+        }
+        else
+        {
+            glitch();
         }
 
-        return falling;
+        return true;
+    }
+
+    /**
+     * Start a pulse without a rising edge; ISR only
+     *
+     * For receivers whose channel pulses are back to back: the end of one channel starts the next, and its own
+     * rising edge, which may be seen late, is then ignored.
+     *
+     * @param now Current time [timer counts, low 16 bits]
+     */
+    void start(uint16_t now)
+    {
+        _start = now;
+        _has_prev_start = true;
+        _started = true;
+    }
+
+    // branch-free (min/max only) medians
+    static uint16_t median3(uint16_t a, uint16_t b, uint16_t c)
+    {
+        using estd::min;
+        using estd::max;
+        return max(min(a, b), min(max(a, b), c));
+    }
+
+    static uint16_t median(const uint16_t (&h)[3]) { return median3(h[0], h[1], h[2]); }
+
+    static uint16_t median(const uint16_t (&h)[5])
+    {
+        using estd::min;
+        using estd::max;
+
+        // drop the lowest and highest of the first four, then take the median with the fifth
+        return median3(h[4], max(min(h[0], h[1]), min(h[2], h[3])), min(max(h[0], h[1]), max(h[2], h[3])));
     }
 
 private:
-    static void pci_setup(byte pin)
+    void glitch()
     {
-        *digitalPinToPCMSK(pin) |= bit(digitalPinToPCMSKbit(pin));  // enable pin
-        PCIFR |= bit(digitalPinToPCICRbit(pin));  // clear any outstanding interrupt
-        PCICR |= bit(digitalPinToPCICRbit(pin));  // enable interrupt for the group
+        if (_glitches < 255)
+        {
+            ++_glitches;
+        }
     }
 
 private:
     const uint8_t _pin;
-    const uint8_t _mask;
-    volatile uint32_t _start;
-    volatile uint32_t _pulse_length;
-    volatile uint8_t _prev_pind;
+
+    // ISR side; one 16-bit timestamp for pulse start and period, packed flags keep the per-channel state small
+    uint16_t _start = 0;  // of the last pulse [timer counts, low 16 bits]
+    uint16_t _pulse = 0;
+    uint8_t _started : 1;
+    uint8_t _has_prev_start : 1;
+    uint8_t _fresh : 1;
+    volatile uint8_t _glitches = 0;
+
+    // main loop side
+    uint16_t _history[FILTER_LEN];
+    uint8_t _head = 0;
+    uint32_t _last_valid = 0;
 };
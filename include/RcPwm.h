@@ -3,13 +3,27 @@
 #include <avr/interrupt.h>
 #include <Arduino.h>
 
+// PWM channels, each costs 19 bytes of RAM; set to the number of motors with -DMAX_PWM_COUNT=n
+#ifndef MAX_PWM_COUNT
 #define MAX_PWM_COUNT 12
+#endif
 
 class RcPwm
 {
 public:
+    enum class Mode : uint8_t
+    {
+        Sequential,  // one channel after the other; train length is the sum of all pulses
+        Simultaneous  // all channels start together and end in order of width; trains repeat every 5 ms (200 Hz)
+    };
+
     RcPwm();
 
+    /**
+     * Select how channels are scheduled within a PWM train; takes effect with the next train
+     */
+    static void setMode(Mode mode);
+
     /**
      * Attach the given pin to the next free channel, sets pinMode, returns channel number or 0 if failure
      */
@@ -40,16 +54,33 @@ public:
     bool attached() const;
 
     /**
-     * Run PWM now
+     * Run PWM now; in simultaneous mode, keep the trains repeating with the latest values
+     *
+     * Simultaneous trains repeat from the timer interrupt; if runNow() is not called for 50 ms (the control loop
+     * stopped), they stop, and the next runNow() starts them again.
      */
     static void runNow();
 
+    /**
+     * @return \c true if runNow() is due: no train ran for the refresh interval (sequential), or the trains were
+     * repeated for 25 ms without it (simultaneous)
+     */
     static bool needsToRun();
 
+    /**
+     * End all pulses now and emit no further trains until reset; ISR safe
+     *
+     * ESCs and servos treat the missing signal as loss of signal (motors off).
+     */
+    static void stop();
+
     static void runImpl(bool start);
 private:
     static void initISR();
     static boolean isTimerActive();
+    static void runSequential(bool start);
+    static void runSimultaneous(bool start);
+    static void buildEdges();
 
     struct PwmPin
     {
@@ -63,9 +94,38 @@ private:
         volatile uint16_t ticks;
     } ;
 
+    typedef decltype(portOutputRegister(0)) PortRegister;
+
+    // falling edge of a simultaneous train; the pin is written through its port, which takes a fraction of the time
+    // of digitalWrite()
+    struct Edge
+    {
+        uint16_t ticks;  // from the start of the train
+        PortRegister out;
+        uint8_t mask;
+    };
+
+    // pins of one port raised at the start of a simultaneous train
+    struct Port
+    {
+        PortRegister out;
+        uint8_t mask;
+    };
+
     uint8_t _index;  // index into the channel data for this pwm
     static volatile bool _needs_run;
     static volatile int8_t _counter; // counter for the pwm being pulsed for each timer (or -1 if refresh interval)
     static Pwm _pwms[MAX_PWM_COUNT]; // static array of pwm structures
     static uint8_t _pwm_count; // the total number of attached _pwms
+    static Mode _mode;
+    static volatile bool _stopped;
+    static volatile uint8_t _repeats;  // simultaneous trains started by the ISR since the last runNow()
+
+    // edge and port lists sorted by width: the ISR uses the active ones, the main loop rebuilds the others on changes
+    static Edge _edges[2][MAX_PWM_COUNT];
+    static uint8_t _edge_count[2];
+    static Port _ports[2][MAX_PWM_COUNT];
+    static uint8_t _port_count[2];
+    static uint8_t _active_edges;
+    static volatile bool _edges_changed;
 };
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "Timer.h"
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+/**
+ * Fixed-capacity cooperative scheduler
+ *
+ * Tasks are released periodically or explicitly (e.g. by an interrupt flag or another task) and run to completion,
+ * highest priority first, one task per call of run(). Priority is the order in which tasks were added.
+ *
+ * Each task has a deadline relative to its release. A task starting later than that, or released again before it
+ * ran, counts as an overrun; tasks that only make sense on time (e.g. those tied to a quiet window) can be dropped
+ * instead of run late. A task can also have a budget for its run time; running longer counts as an overrun as well.
+ * All times are Timer counts, compared by unsigned difference, so they are safe across wrap.
+ *
+ * With no task ready the CPU can idle in SLEEP_MODE_IDLE until the next interrupt. The Timer2 overflow interrupt
+ * bounds every sleep to 128 us, so periodic releases are at most that late, and interrupt-driven releases wake the
+ * CPU immediately.
+ *
+ * @tparam CAPACITY Maximum number of tasks
+ */
+template <uint8_t CAPACITY>
+class Scheduler
+{
+public:
+    typedef void (*Function)();
+
+    // window over which utilisation is measured [timer counts]
+    static constexpr uint32_t UTILISATION_WINDOW = 1000000UL * COUNT_PER_MICROS;
+
+    /**
+     * Add a task
+     *
+     * @param function Task body
+     * @param period Release period [timer counts], 0 to release only explicitly
+     * @param deadline Maximum delay from release to start [timer counts]
+     * @param drop_late \c true to skip a run that missed its deadline
+     * @return uint8_t Task id
+     */
+    uint8_t add(Function function, uint32_t period, uint32_t deadline, bool drop_late = false)
+    {
+        if (_count >= CAPACITY)
+            return CAPACITY;
+
+        Task& t = _tasks[_count];
+        t.function = function;
+        t.period = period;
+        t.deadline = deadline;
+        t.drop_late = drop_late;
+        return _count++;
+    }
+
+    /**
+     * Limit the run time of \p task; longer runs count as overruns
+     *
+     * @param task Task id
+     * @param budget Maximum run time [timer counts], 0 for no limit
+     */
+    void setBudget(uint8_t task, uint32_t budget) { _tasks[task].budget = budget; }
+
+    /**
+     * Make \p task ready to run
+     *
+     * @param task Task id
+     * @param now Release time [timer counts]
+     */
+    void release(uint8_t task, uint32_t now)
+    {
+        Task& t = _tasks[task];
+        if (t.ready)
+        {
+            overrun(t);
+        }
+
+        t.ready = true;
+        t.released = now;
+    }
+
+    /**
+     * Release due periodic tasks and run the highest priority ready one
+     *
+     * @param now Current time [timer counts]
+     * @return \c true if a task ran
+     */
+    bool run(uint32_t now)
+    {
+        for (uint8_t i = 0; i < _count; ++i)
+        {
+            Task& t = _tasks[i];
+            if (t.period != 0 && now - t.next >= t.period)
+            {
+                release(i, now);
+
+                // skip missed periods instead of catching up
+                t.next += t.period;
+                if (now - t.next >= t.period)
+                {
+                    t.next = now;
+                }
+            }
+        }
+
+        for (uint8_t i = 0; i < _count; ++i)
+        {
+            Task& t = _tasks[i];
+            if (!t.ready)
+                continue;
+
+            t.ready = false;
+
+            if (now - t.released > t.deadline)
+            {
+                overrun(t);
+                if (t.drop_late)
+                    continue;
+            }
+
+            uint32_t start = Timer::instance().get_count();
+            t.function();
+
+            uint32_t end = Timer::instance().get_count();
+            finished(t, end - start);
+            account(now, end);
+            return true;
+        }
+
+        account(now, now);
+        return false;
+    }
+
+    /**
+     * Sleep until the next interrupt unless a task is ready or \p pending reports work
+     *
+     * @param pending Checks the flags set by ISRs that release tasks; called with interrupts disabled, so a flag set
+     *                just before sleeping is not missed
+     */
+    void idle(bool (*pending)())
+    {
+        for (uint8_t i = 0; i < _count; ++i)
+        {
+            if (_tasks[i].ready)
+                return;
+        }
+
+        uint32_t start = Timer::instance().get_count();
+
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        noInterrupts();
+        if (!pending())
+        {
+            sleep_enable();
+            interrupts();  // the instruction after SEI (the SLEEP) still executes before any pending interrupt
+            sleep_cpu();
+            sleep_disable();
+        }
+        interrupts();
+
+        _asleep += Timer::instance().get_count() - start;
+    }
+
+    // overruns of \p task (saturating)
+    uint16_t overruns(uint8_t task) const { return _tasks[task].overruns; }
+
+    // overruns of all tasks (saturating)
+    uint16_t overruns() const
+    {
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < _count; ++i)
+        {
+            sum += _tasks[i].overruns;
+        }
+        return sum < 0xffff ? static_cast<uint16_t>(sum) : 0xffff;
+    }
+
+    // longest run of \p task [timer counts] (saturating)
+    uint16_t longest(uint8_t task) const { return _tasks[task].longest; }
+
+    // share of time spent in tasks during the last complete window [%]
+    uint8_t utilisation() const { return _utilisation; }
+
+    // share of time the CPU was awake (not in idle()) during the last complete window [%]
+    uint8_t dutyCycle() const { return _duty_cycle; }
+
+private:
+    struct Task
+    {
+        Function function = nullptr;
+        uint32_t period = 0;
+        uint32_t deadline = 0;
+        uint32_t next = 0;
+        uint32_t released = 0;
+        uint32_t budget = 0;
+        uint16_t overruns = 0;
+        uint16_t longest = 0;
+        bool ready = false;
+        bool drop_late = false;
+    };
+
+    static void overrun(Task& t)
+    {
+        if (t.overruns < 0xffff)
+        {
+            ++t.overruns;
+        }
+    }
+
+    static void finished(Task& t, uint32_t duration)
+    {
+        if (duration > t.longest)
+        {
+            t.longest = duration < 0xffff ? static_cast<uint16_t>(duration) : 0xffff;
+        }
+
+        if (t.budget != 0 && duration > t.budget)
+        {
+            overrun(t);
+        }
+    }
+
+    void account(uint32_t start, uint32_t end)
+    {
+        _busy += end - start;
+
+        uint32_t elapsed = end - _window_start;
+        if (elapsed >= UTILISATION_WINDOW)
+        {
+            _utilisation = static_cast<uint8_t>(_busy / (elapsed / 100));
+            _duty_cycle = static_cast<uint8_t>(100 - _asleep / (elapsed / 100));
+            _busy = 0;
+            _asleep = 0;
+            _window_start = end;
+        }
+    }
+
+private:
+    Task _tasks[CAPACITY];
+    uint8_t _count = 0;
+    uint32_t _busy = 0;
+    uint32_t _asleep = 0;
+    uint32_t _window_start = 0;
+    uint8_t _utilisation = 0;
+    uint8_t _duty_cycle = 100;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Double-buffered sequence lock for passing a value from an ISR to the main loop
+ *
+ * The writer fills the buffer the reader is not pointed at and then publishes it by incrementing the sequence, so a
+ * reader interrupted by one write still copies a complete value. Only a second write during the same copy (i.e. a
+ * copy taking longer than a frame) forces a retry. Neither side disables interrupts.
+ *
+ * @tparam T Value type, copied as a whole
+ */
+template <typename T>
+class SeqLock
+{
+public:
+    /**
+     * Publish \p value; single writer only (the ISR)
+     */
+    void write(const T& value)
+    {
+        uint8_t next = _seq + 1;
+        _buffers[next & 1] = value;
+        barrier();
+        _seq = next;
+    }
+
+    /**
+     * Take a consistent snapshot of the last published value
+     *
+     * @param value Snapshot
+     * @return uint8_t Sequence of the snapshot, changes with every write()
+     */
+    uint8_t read(T& value) const
+    {
+        uint8_t seq;
+        do
+        {
+            seq = _seq;
+            barrier();
+            value = _buffers[seq & 1];
+            barrier();
+        } while (static_cast<uint8_t>(_seq - seq) >= 2);
+
+        return seq;
+    }
+
+private:
+    static void barrier() { __asm__ __volatile__("" ::: "memory"); }
+
+    T _buffers[2] = {};
+    volatile uint8_t _seq = 0;
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Gyro.h"
+#include "Timer.h"
+#include <Arduino.h>
+
+/**
+ * Planar velocity and sideslip estimate from body-frame acceleration and yaw rate
+ *
+ * Integrates the body-frame kinematics dv_x/dt = a_x + r * v_y, dv_y/dt = a_y - r * v_x (x forward, y left, r
+ * counter-clockwise), so that the centripetal acceleration of a clean turn does not show up as slip. A leak per
+ * update bounds the drift of the open integration: weak on the forward speed, which the turn compensation relies
+ * on, stronger on the lateral velocity, which is the output. Resting on the ground (hover fan off) zeroes the
+ * velocity and refines the accelerometer bias, which also absorbs the mounting tilt.
+ *
+ * Velocities are 1/16 mm/s in int32_t; all steps are integer multiplications, one division per axis and shifts.
+ */
+class SlipEstimator
+{
+public:
+    // raw sensitivity at +/- 2 g
+    static constexpr float LSB_PER_G = 16384.0f;
+
+    // integration step: 8 us (16 Timer counts)
+    static constexpr uint8_t DT_SHIFT = 4;
+
+    // accel * dt [LSB * 8 us] per velocity unit (1/16 mm/s)
+    static constexpr int32_t ACCEL_DT_PER_UNIT = static_cast<int32_t>(LSB_PER_G / (9806.65f * 16.0f * 8e-6f) + 0.5f);
+
+    // rate * dt [gyro LSB * 8 us] per rotation unit (1/65536 rad)
+    static constexpr int32_t RATE_DT_PER_ANGLE =
+        static_cast<int32_t>(Gyro::LSB_PER_DPS * (180.0f / 3.14159265f) / (65536.0f * 8e-6f) + 0.5f);
+
+    // longest integration step accepted (keeps accel * dt inside int32_t)
+    static constexpr uint32_t MAX_DT_COUNT = 0xffffUL;
+
+    // velocity leak per update: v -= v / 2^shift (time constants ~10 s and ~0.6 s at 50 Hz)
+    static constexpr uint8_t LONGITUDINAL_LEAK_SHIFT = 9;
+    static constexpr uint8_t LATERAL_LEAK_SHIFT = 5;
+
+    // velocity limit [1/16 mm/s]; keeps velocity * rotation inside int32_t
+    static constexpr int32_t VELOCITY_LIMIT = 8000L * 16;
+
+    // rotation limit per step [1/65536 rad]
+    static constexpr int32_t ANGLE_LIMIT = 16384;
+
+    /**
+     * Integrate one sample
+     *
+     * @param ax Longitudinal acceleration [accel LSB], forward positive
+     * @param ay Lateral acceleration [accel LSB], left positive
+     * @param rate Yaw rate [gyro LSB], counter-clockwise positive
+     * @param now Timer count when the sample was taken
+     */
+    void update(int16_t ax, int16_t ay, int16_t rate, uint32_t now)
+    {
+        int16_t dt = step(now);
+
+        // rotation of the body during this step
+        int32_t angle = clamp((static_cast<int32_t>(rate) * dt) / RATE_DT_PER_ANGLE, ANGLE_LIMIT);
+
+        // velocity change from acceleration, keeping the sub-unit remainder
+        _remainder_x += (static_cast<int32_t>(ax) - bias(_bias_x_q4)) * dt;
+        _remainder_y += (static_cast<int32_t>(ay) - bias(_bias_y_q4)) * dt;
+        int32_t dvx = _remainder_x / ACCEL_DT_PER_UNIT;
+        int32_t dvy = _remainder_y / ACCEL_DT_PER_UNIT;
+        _remainder_x -= dvx * ACCEL_DT_PER_UNIT;
+        _remainder_y -= dvy * ACCEL_DT_PER_UNIT;
+
+        int32_t vx = _vx;
+        int32_t vy = _vy;
+        vx += dvx + ((_vy * angle) >> 16);
+        vy += dvy - ((_vx * angle) >> 16);
+
+        _vx = clamp(vx - (vx >> LONGITUDINAL_LEAK_SHIFT), VELOCITY_LIMIT);
+        _vy = clamp(vy - (vy >> LATERAL_LEAK_SHIFT), VELOCITY_LIMIT);
+    }
+
+    /**
+     * Resting on the ground: zero the velocity and refine the accelerometer bias
+     *
+     * @param ax Longitudinal acceleration [accel LSB]
+     * @param ay Lateral acceleration [accel LSB]
+     * @param now Timer count when the sample was taken
+     */
+    void rest(int16_t ax, int16_t ay, uint32_t now)
+    {
+        step(now);
+
+        _bias_x_q4 += ((static_cast<int32_t>(ax) * 16) - _bias_x_q4) >> BIAS_SHIFT;
+        _bias_y_q4 += ((static_cast<int32_t>(ay) * 16) - _bias_y_q4) >> BIAS_SHIFT;
+
+        _vx = _vy = 0;
+        _remainder_x = _remainder_y = 0;
+    }
+
+    // longitudinal velocity [mm/s], forward positive
+    int16_t longitudinal() const { return static_cast<int16_t>(_vx / 16); }
+
+    // lateral velocity [mm/s], left positive
+    int16_t lateral() const { return static_cast<int16_t>(_vy / 16); }
+
+    /**
+     * Yaw rate set-point offset against the lateral slide
+     *
+     * @param shift Gain as power of two: 1/2^shift gyro units per mm/s
+     * @param limit Largest offset [gyro units]
+     * @return int16_t Offset [gyro units], positive for a left (positive lateral) slide
+     */
+    int16_t counterYaw(uint8_t shift, int16_t limit) const
+    {
+        return static_cast<int16_t>(clamp(lateral() >> shift, limit));
+    }
+
+    // sideslip angle [degrees] (small angle approximation), 0 below 0.5 m/s forward speed
+    int16_t sideslip() const
+    {
+        if (_vx < MIN_SIDESLIP_SPEED && _vx > -MIN_SIDESLIP_SPEED)
+            return 0;
+
+        return static_cast<int16_t>((_vy * 57) / _vx);
+    }
+
+private:
+    static constexpr uint8_t BIAS_SHIFT = 6;
+    static constexpr int32_t MIN_SIDESLIP_SPEED = 500L * 16;
+
+    static int32_t clamp(int32_t value, int32_t limit)
+    {
+        if (value > limit)
+            return limit;
+        if (value < -limit)
+            return -limit;
+        return value;
+    }
+
+    static int16_t bias(int32_t bias_q4) { return static_cast<int16_t>((bias_q4 + 8) >> 4); }
+
+    // integration step since the last sample [8 us]
+    int16_t step(uint32_t now)
+    {
+        uint32_t dt = now - _last_count;
+        _last_count = now;
+
+        if (dt > MAX_DT_COUNT)
+        {
+            dt = MAX_DT_COUNT;
+        }
+
+        return static_cast<int16_t>(dt >> DT_SHIFT);
+    }
+
+private:
+    int32_t _vx = 0;
+    int32_t _vy = 0;
+    int32_t _remainder_x = 0;
+    int32_t _remainder_y = 0;
+    int32_t _bias_x_q4 = 0;
+    int32_t _bias_y_q4 = 0;
+    uint32_t _last_count = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Startup sequencer: waits for a set of readiness conditions instead of a fixed time
+ *
+ * Conditions are bits defined by the application and checked every frame while starting up, so slow ones (ESC
+ * arming, sensor settling, receiver lock) overlap. A condition is latched once met. Startup completes when all
+ * required conditions are met, or at the latest after the timeout, with the missing ones left for telemetry.
+ */
+class Startup
+{
+public:
+    /**
+     * @param required Bit set of conditions to wait for
+     * @param timeout_ms Longest startup [ms]
+     */
+    Startup(uint8_t required, uint32_t timeout_ms)
+        : _required(required)
+        , _timeout_ms(timeout_ms)
+    {}
+
+    /**
+     * Begin waiting
+     *
+     * @param now Current time [ms]
+     */
+    void start(uint32_t now)
+    {
+        _start_ms = now;
+        _met = 0;
+        _done = false;
+    }
+
+    /**
+     * Record the conditions met in this frame
+     *
+     * @param conditions Bit set of conditions currently met
+     * @param now Current time [ms]
+     * @return \c true once startup is complete
+     */
+    bool update(uint8_t conditions, uint32_t now)
+    {
+        if (_done)
+            return true;
+
+        _met |= conditions & _required;
+
+        if (_met == _required || now - _start_ms >= _timeout_ms)
+        {
+            _done = true;
+            _ready_ms = now;
+        }
+
+        return _done;
+    }
+
+    bool done() const { return _done; }
+
+    // time since start [ms]
+    uint32_t elapsed(uint32_t now) const { return now - _start_ms; }
+
+    // required conditions not met (at timeout)
+    uint8_t missing() const { return _required & ~_met; }
+
+    // time of completion [ms], 0 while starting
+    uint32_t readyTime() const { return _done ? _ready_ms : 0; }
+
+private:
+    const uint8_t _required;
+    const uint32_t _timeout_ms;
+    uint32_t _start_ms = 0;
+    uint32_t _ready_ms = 0;
+    uint8_t _met = 0;
+    bool _done = false;
+};
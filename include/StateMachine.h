@@ -0,0 +1,216 @@
+#pragma once
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+/**
+ * Table-driven state machine
+ *
+ * States and transitions are constant tables in flash. Each update evaluates the transitions of the current state in
+ * table order against a bit set of events; the first one whose masked events match fires and runs the exit action of
+ * the old state, the transition action and the entry action of the new state. Without a transition the run action of
+ * the current state is called, dispatched through the state table indexed by state.
+ *
+ * New modes only need new table rows and actions, no changes to the engine. The table checks below are constexpr, so a
+ * transition table can be verified with static_assert where it is defined.
+ *
+ * @tparam State Enumeration of states, values 0 .. STATE_COUNT - 1
+ * @tparam Context Per-update input passed to all actions
+ * @tparam STATE_COUNT Number of states
+ */
+template <typename State, typename Context, uint8_t STATE_COUNT>
+class StateMachine
+{
+public:
+    typedef void (*Action)(const Context&);
+
+    struct StateInfo
+    {
+        const char* name;  // in PROGMEM
+        Action enter;  // may be nullptr
+        Action run;  // may be nullptr
+        Action exit;  // may be nullptr
+    };
+
+    struct Transition
+    {
+        State from;
+        uint8_t mask;  // events tested
+        uint8_t value;  // required state of the tested events
+        State to;
+        Action action;  // may be nullptr
+    };
+
+    /**
+     * @param states State table in PROGMEM, indexed by state
+     * @param transitions Transition table in PROGMEM
+     * @param transition_count Number of transitions
+     * @param initial Initial state, entered on first update
+     */
+    StateMachine(const StateInfo* states, const Transition* transitions, uint8_t transition_count, State initial)
+        : _states(states)
+        , _transitions(transitions)
+        , _transition_count(transition_count)
+        , _state(initial)
+    {}
+
+    /**
+     * Evaluate transitions, or run current state if none fires
+     *
+     * @param events Bit set of events of this update
+     * @param context Input passed to actions
+     * @param now Current time [ms]
+     */
+    void update(uint8_t events, const Context& context, uint32_t now)
+    {
+        if (!_started)
+        {
+            _started = true;
+            enter(_state, context, now);
+            return;
+        }
+
+        for (uint8_t i = 0; i < _transition_count; ++i)
+        {
+            Transition t;
+            memcpy_P(&t, &_transitions[i], sizeof(t));
+
+            if (t.from == _state && (events & t.mask) == t.value)
+            {
+                auto from = info(_state);
+                if (from.exit)
+                {
+                    from.exit(context);
+                }
+
+                _time_in_state[index(_state)] += now - _entered;
+
+                if (t.action)
+                {
+                    t.action(context);
+                }
+
+                ++_transition_total;
+                enter(t.to, context, now);
+                return;
+            }
+        }
+
+        auto current = info(_state);
+        if (current.run)
+        {
+            current.run(context);
+        }
+    }
+
+    State state() const { return _state; }
+
+    /**
+     * Table check: all rows are between valid states and only test events below \p event_count; \c value only sets
+     * tested events
+     */
+    template <uint8_t N>
+    static constexpr bool valid(const Transition (&table)[N], uint8_t event_count, uint8_t row = 0)
+    {
+        return row >= N ||
+            (index(table[row].from) < STATE_COUNT && index(table[row].to) < STATE_COUNT &&
+                (table[row].mask >> event_count) == 0 && (table[row].value & ~table[row].mask) == 0 &&
+                valid(table, event_count, row + 1));
+    }
+
+    // table check: every state has a transition out
+    template <uint8_t N>
+    static constexpr bool exits(const Transition (&table)[N], uint8_t state = 0)
+    {
+        return state >= STATE_COUNT || (hasRow(table, state, true) && exits(table, state + 1));
+    }
+
+    // table check: every state but \p initial is the target of a transition
+    template <uint8_t N>
+    static constexpr bool reachable(const Transition (&table)[N], State initial, uint8_t state = 0)
+    {
+        return state >= STATE_COUNT ||
+            ((state == index(initial) || hasRow(table, state, false)) && reachable(table, initial, state + 1));
+    }
+
+    // table check: every row can fire, i.e. no earlier row of the same state matches all events it matches
+    template <uint8_t N>
+    static constexpr bool unshadowed(const Transition (&table)[N], uint8_t row = 0)
+    {
+        return row >= N || (!shadowed(table, row, 0) && unshadowed(table, row + 1));
+    }
+
+    // name of \p state, in flash
+    const __FlashStringHelper* name(State state) const
+    {
+        return index(state) < STATE_COUNT ? reinterpret_cast<const __FlashStringHelper*>(info(state).name)
+                                          : F("<invalid>");
+    }
+
+    // number of times \p state was entered
+    uint16_t entries(State state) const { return _entries[index(state)]; }
+
+    // total number of transitions
+    uint16_t transitions() const { return _transition_total; }
+
+    // time spent in current state [ms]
+    uint32_t timeInState(uint32_t now) const { return now - _entered; }
+
+    // total time spent in \p state, including the current stay [ms]
+    uint32_t totalTime(State state, uint32_t now) const
+    {
+        return _time_in_state[index(state)] + (state == _state ? now - _entered : 0);
+    }
+
+private:
+    static constexpr uint8_t index(State state) { return static_cast<uint8_t>(state); }
+
+    // true if a row starts (\p from) or ends in \p state
+    template <uint8_t N>
+    static constexpr bool hasRow(const Transition (&table)[N], uint8_t state, bool from, uint8_t row = 0)
+    {
+        return row < N &&
+            (index(from ? table[row].from : table[row].to) == state || hasRow(table, state, from, row + 1));
+    }
+
+    // true if row \p earlier (or a later one before \p row) matches whenever \p row does
+    template <uint8_t N>
+    static constexpr bool shadowed(const Transition (&table)[N], uint8_t row, uint8_t earlier)
+    {
+        return earlier < row &&
+            ((table[earlier].from == table[row].from && (table[earlier].mask & ~table[row].mask) == 0 &&
+                 (table[row].value & table[earlier].mask) == table[earlier].value) ||
+                shadowed(table, row, earlier + 1));
+    }
+
+    StateInfo info(State state) const
+    {
+        StateInfo i;
+        memcpy_P(&i, &_states[index(state)], sizeof(i));
+        return i;
+    }
+
+    void enter(State state, const Context& context, uint32_t now)
+    {
+        _state = state;
+        _entered = now;
+        ++_entries[index(state)];
+
+        auto to = info(state);
+        if (to.enter)
+        {
+            to.enter(context);
+        }
+    }
+
+private:
+    const StateInfo* const _states;
+    const Transition* const _transitions;
+    const uint8_t _transition_count;
+    State _state;
+    bool _started = false;
+    uint32_t _entered = 0;
+    uint16_t _transition_total = 0;
+    uint16_t _entries[STATE_COUNT] = {};
+    uint32_t _time_in_state[STATE_COUNT] = {};
+};
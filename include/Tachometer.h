@@ -0,0 +1,111 @@
+#pragma once
+
+#include "PinChange.h"
+#include "Timer.h"
+#include <Arduino.h>
+
+/**
+ * Fan speed from an ESC frequency output (e.g. the RPM signal of BLHeli ESCs)
+ *
+ * The pin change ISR of the tachometer port counts rising edges inline and stores the time of the last one; on the
+ * falling edges, which fire the interrupt as well, it returns after the level check (PinChange::rising()). The main
+ * loop turns that into RPM from the number of edges and the time between the last edges of two updates, so the
+ * measurement spans whole periods and needs no gate time.
+ */
+class Tachometer
+{
+public:
+    // without an edge for this long the fan is considered stopped [timer counts]
+    static constexpr uint32_t STOP_TIMEOUT = 100000UL * COUNT_PER_MICROS;
+
+    /**
+     * @param pin Input pin, any pin change capable pin
+     * @param pulses_per_rev Output pulses per revolution (usually the motor pole pairs)
+     */
+    Tachometer(uint8_t pin, uint8_t pulses_per_rev)
+        : _pin(pin)
+        , _mask(bit(digitalPinToPCMSKbit(pin)))
+        , _pulses_per_rev(pulses_per_rev)
+    {}
+
+    /**
+     * Enable edge detection; the port's ISR passes PinChange::rising() on to edges()
+     */
+    void setup()
+    {
+        pinMode(_pin, INPUT_PULLUP);
+        PinChange::attach(_pin);
+    }
+
+    /**
+     * Count a rising edge of the pin; ISR only
+     *
+     * @param rising Rising edges of the port, from PinChange::rising()
+     * @param now Current time [timer counts]
+     */
+    void edges(uint8_t rising, uint32_t now) __attribute__((always_inline))
+    {
+        if (rising & _mask)
+        {
+            ++_edges;
+            _last_edge = static_cast<uint16_t>(now);
+        }
+    }
+
+    /**
+     * Update speed from the edges since the last call; main loop only, at least every 32 ms
+     *
+     * @param now Current time [timer counts]
+     */
+    void update(uint32_t now)
+    {
+        uint8_t SREG_old = SREG;
+        noInterrupts();
+        uint8_t edges = _edges;
+        uint16_t last_edge = _last_edge;
+        SREG = SREG_old;
+
+        uint8_t count = edges - _prev_edges;
+        if (count != 0)
+        {
+            // new edges happened since the last update, so within 32 ms: extend the ISR timestamp to 32 bits
+            uint32_t edge = now - static_cast<uint16_t>(static_cast<uint16_t>(now) - last_edge);
+            uint32_t period = (edge - _prev_edge) / count;
+            if (_running && period != 0)
+            {
+                // rpm = 60e6 us/min / (period [us] * pulses_per_rev)
+                _rpm = static_cast<uint16_t>((60000000UL * COUNT_PER_MICROS / _pulses_per_rev) / period);
+            }
+
+            _prev_edges = edges;
+            _prev_edge = edge;
+            _running = true;
+        }
+        else if (now - _prev_edge > STOP_TIMEOUT)
+        {
+            _rpm = 0;
+            _running = false;
+        }
+    }
+
+    // fan speed [1/min]
+    uint16_t rpm() const { return _rpm; }
+
+    // \c true while edges arrive
+    bool running() const { return _running; }
+
+private:
+    const uint8_t _pin;
+    const uint8_t _mask;  // in the port's PCMSK
+    const uint8_t _pulses_per_rev;
+
+    // ISR side
+    volatile uint8_t _edges = 0;
+    volatile uint16_t _last_edge = 0;
+
+    // main loop side
+    uint8_t _prev_edges = 0;
+    uint32_t _prev_edge = 0;  // [timer counts]
+    uint16_t _rpm = 0;
+    bool _running = false;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "IntMath.h"
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+namespace thrust_curve {
+
+/**
+ * ESC offset for table point \p i of a quadratic fan (thrust ~ offset^2)
+ *
+ * @param max_us ESC offset at full thrust [us]
+ * @param i Table point 0 .. 16 (0 .. full thrust)
+ */
+constexpr uint16_t quadratic_us(uint16_t max_us, uint8_t i)
+{
+    return static_cast<uint16_t>(int_math::isqrt((static_cast<uint32_t>(max_us) * max_us * i) / 16));
+}
+
+/**
+ * Thrust-to-us table of a quadratic fan, generated at compile time
+ *
+ * @tparam MAX_US ESC offset at full thrust [us]
+ */
+template <uint16_t MAX_US>
+struct QuadraticTable
+{
+    static const uint16_t values[17];
+};
+
+template <uint16_t MAX_US>
+const uint16_t QuadraticTable<MAX_US>::values[17] PROGMEM = {
+    quadratic_us(MAX_US, 0), quadratic_us(MAX_US, 1), quadratic_us(MAX_US, 2), quadratic_us(MAX_US, 3),
+    quadratic_us(MAX_US, 4), quadratic_us(MAX_US, 5), quadratic_us(MAX_US, 6), quadratic_us(MAX_US, 7),
+    quadratic_us(MAX_US, 8), quadratic_us(MAX_US, 9), quadratic_us(MAX_US, 10), quadratic_us(MAX_US, 11),
+    quadratic_us(MAX_US, 12), quadratic_us(MAX_US, 13), quadratic_us(MAX_US, 14), quadratic_us(MAX_US, 15),
+    quadratic_us(MAX_US, 16)
+};
+
+}  // namespace thrust_curve
+
+/**
+ * Linearises fan thrust: maps a signed thrust command onto a signed ESC offset from the zero-thrust point
+ *
+ * Tables have 17 points over 0 .. THRUST_MAX, live in flash and are interpolated linearly. Full thrust corresponds
+ * to the full-stick offset the fans were tuned for with each battery type (750 us / cells, 480 us at most).
+ * Tables built from thrust-stand measurements (see tools/thrust_table.py) can be passed to select() instead.
+ */
+class ThrustCurve
+{
+public:
+    static constexpr int16_t THRUST_MAX = 512;
+    static constexpr uint8_t SEGMENT_SHIFT = 5;  // THRUST_MAX / 16 segments
+    static constexpr uint8_t POINTS = 17;
+
+    ThrustCurve()
+        : _table(forCells(2))
+    {}
+
+    // select table (in PROGMEM, 17 points)
+    void select(const uint16_t* table) { _table = table; }
+
+    static const uint16_t* forCells(uint8_t cells)
+    {
+        switch (cells)
+        {
+        case 1: return thrust_curve::QuadraticTable<480>::values;
+        case 2: return thrust_curve::QuadraticTable<375>::values;
+        case 3: return thrust_curve::QuadraticTable<250>::values;
+        default: return thrust_curve::QuadraticTable<187>::values;
+        }
+    }
+
+    /**
+     * @param thrust Thrust command, -THRUST_MAX .. THRUST_MAX (clamped)
+     * @return int16_t ESC offset from zero thrust [us]
+     */
+    int16_t toMicroseconds(int16_t thrust) const
+    {
+        uint16_t magnitude = thrust < 0 ? -thrust : thrust;
+        int16_t us;
+
+        if (magnitude >= static_cast<uint16_t>(THRUST_MAX))
+        {
+            us = pgm_read_word(&_table[POINTS - 1]);
+        }
+        else
+        {
+            uint8_t i = magnitude >> SEGMENT_SHIFT;
+            uint8_t frac = magnitude & ((1 << SEGMENT_SHIFT) - 1);
+            int16_t y0 = pgm_read_word(&_table[i]);
+            int16_t y1 = pgm_read_word(&_table[i + 1]);
+            us = y0 + (((y1 - y0) * frac) >> SEGMENT_SHIFT);
+        }
+
+        return thrust < 0 ? -us : us;
+    }
+
+private:
+    const uint16_t* _table;
+};
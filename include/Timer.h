@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 constexpr int16_t COUNT_PER_MICROS = 2;
+constexpr int16_t COUNT_PER_OVERFLOW = 256;  // Timer2 overflows (and interrupts) every 128 us
 
 // high-precision timer
 class Timer
@@ -105,9 +106,3 @@ private:
     uint8_t _tccr2b_save;
     volatile uint32_t _offset = 0;
 };
-
-// Interrupt Service Routine (ISR) for when Timer2's counter overflows; this will occur every 128us
-ISR(TIMER2_OVF_vect)  // Timer2's counter has overflowed
-{
-    Timer::instance().increment_overflow_count();  // increment the timer2 overflow counter
-}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+#include <avr/wdt.h>
+
+/**
+ * Hardware watchdog in interrupt and system reset mode
+ *
+ * The main loop kicks the watchdog after each completed control cycle. If it stalls for the timeout, the watchdog
+ * interrupt first calls the expiry handler, which puts the outputs into a safe state without relying on the stalled
+ * code, and the next timeout resets the MCU. Once expired, kick() no longer restarts the watchdog, so the reset
+ * follows even if the loop recovers in between: safe outputs after one timeout, reset after two.
+ *
+ * The reset cause (MCUSR) is saved and the watchdog stopped in .init3, before the C runtime starts, so a watchdog
+ * reset does not turn into a reset loop. A 32-bit marker in uninitialized RAM survives the reset and tells the
+ * restarted firmware that the watchdog fired, also with bootloaders that clear MCUSR.
+ */
+class Watchdog
+{
+public:
+    /**
+     * Expiry handler; called from the watchdog ISR with interrupts disabled
+     */
+    typedef void (*Handler)();
+
+    /**
+     * Start the watchdog; call at the end of setup(), the loop must kick it from then on
+     *
+     * @param timeout Timeout, one of the WDTO_xxx constants of avr/wdt.h
+     * @param on_expiry Called when the timeout expires, before the reset
+     */
+    static void setup(uint8_t timeout, Handler on_expiry);
+
+    /**
+     * Restart the timeout
+     */
+    static void kick() __attribute__((always_inline))
+    {
+        if (!_expired)
+        {
+            wdt_reset();
+        }
+    }
+
+    /**
+     * @return \c true if the last reset was caused by the watchdog
+     */
+    static bool caused_reset() { return _caused_reset; }
+
+    /**
+     * Handle expiry; ISR only
+     */
+    static void expire();
+
+private:
+    static Handler _on_expiry;
+    static volatile bool _expired;
+    static bool _caused_reset;
+};
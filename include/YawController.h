@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include <estd/algorithm.h>
+
+/**
+ * Fixed-point yaw-rate PID controller with stick feed-forward
+ *
+ * Gains are Q6 (64 == 1.0) and applied once per control frame, so the frame period is folded into the gains. An
+ * update is a few 16x16->32 bit multiplies and shifts without any division; test_benchmark tracks its cost.
+ */
+class YawController
+{
+public:
+    static constexpr int16_t GAIN_SHIFT = 6;
+
+    struct Gains
+    {
+        int16_t kp;  // proportional gain on rate error [Q6]
+        int16_t ki;  // integral gain on rate error, per frame [Q6]
+        int16_t kd;  // derivative gain on measured rate, per frame [Q6]
+        int16_t kff;  // feed-forward gain on stick command [Q6]
+    };
+
+    YawController(const Gains& gains, int16_t limit_us)
+        : _gains(gains)
+        , _limit(limit_us)
+    {
+        reset();
+    }
+
+    /**
+     * Clear integrator and derivative history (e.g. when entering hover)
+     */
+    void reset()
+    {
+        _integral = 0;
+        _prev_rate = 0;
+        _d_filtered = 0;
+    }
+
+    /**
+     * Run one controller step
+     *
+     * @param command_us Steering stick deflection from center [us]
+     * @param setpoint Commanded yaw rate [gyro units]
+     * @param rate Measured yaw rate [gyro units], same sign convention as \p setpoint
+     * @param kp_scale Gain scheduling of the proportional term, 0 (half gain) .. 32 (full gain)
+     * @return Differential fan command [us], limited to +/- limit
+     */
+    int16_t update(int16_t command_us, int16_t setpoint, int16_t rate, int16_t kp_scale)
+    {
+        int16_t error = setpoint - rate;
+
+        // derivative on measurement (no setpoint kick), first-order low-pass with alpha = 1/4
+        int16_t d_rate = rate - _prev_rate;
+        _prev_rate = rate;
+        _d_filtered += (d_rate - _d_filtered) / 4;
+
+        int32_t kp = (static_cast<int32_t>(_gains.kp) * (kp_scale + 32)) / 64;
+        int32_t out = kp * error;
+        out += static_cast<int32_t>(_gains.kff) * command_us;
+        out -= static_cast<int32_t>(_gains.kd) * _d_filtered;
+
+        // anti-windup: only integrate while the output is not saturated in the direction of the error
+        const int32_t limit = static_cast<int32_t>(_limit) << GAIN_SHIFT;
+        int32_t unsaturated = out + _integral;
+        if (!((unsaturated >= limit && error > 0) || (unsaturated <= -limit && error < 0)))
+        {
+            _integral = estd::clamp(_integral + static_cast<int32_t>(_gains.ki) * error, -limit, limit);
+        }
+
+        out = estd::clamp(out + _integral, -limit, limit);
+        return static_cast<int16_t>(out >> GAIN_SHIFT);
+    }
+
+    int16_t integral() const { return static_cast<int16_t>(_integral >> GAIN_SHIFT); }
+
+private:
+    const Gains _gains;
+    const int16_t _limit;
+    int32_t _integral;
+    int16_t _prev_rate;
+    int16_t _d_filtered;
+};
@@ -4,6 +4,7 @@
 constexpr int16_t EEPROM_HOVER_VALUE_ADDR = 0;
 constexpr int16_t EEPROM_IS_INIT_ADDR = 2;
 constexpr int16_t EEPROM_GYRO_BASELINE_ADDR = 4;
+constexpr int16_t EEPROM_HOVER_VOLTAGE_ADDR = 6;
 
 
 void eeprom_write(int16_t address, uint16_t value)
@@ -0,0 +1,34 @@
+#include "PinChange.h"
+#include <avr/interrupt.h>
+
+PinChange::Handler PinChange::_handlers[PinChange::PORT_COUNT][8];
+uint8_t PinChange::_enabled[PinChange::PORT_COUNT];
+uint8_t PinChange::_prev[PinChange::PORT_COUNT];
+
+void PinChange::attach(uint8_t pin, Handler handler)
+{
+    uint8_t port = digitalPinToPCICRbit(pin);
+    uint8_t mask = bit(digitalPinToPCMSKbit(pin));
+
+    uint8_t SREG_old = SREG;
+    noInterrupts();
+
+    _handlers[port][digitalPinToPCMSKbit(pin)] = handler;
+    _enabled[port] |= mask;
+
+    // start from the present level so attaching does not report an edge
+    if (*portInputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin))
+    {
+        _prev[port] |= mask;
+    }
+    else
+    {
+        _prev[port] &= ~mask;
+    }
+
+    *digitalPinToPCMSK(pin) |= mask;  // enable pin
+    PCIFR |= bit(port);  // clear any outstanding interrupt
+    PCICR |= bit(port);  // enable interrupt for the group
+
+    SREG = SREG_old;
+}
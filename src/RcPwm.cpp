@@ -1,4 +1,5 @@
 #include "RcPwm.h"
+#include "Profile.h"
 #include <assert.h>
 #include <estd/algorithm.h>
 
@@ -24,17 +25,38 @@ static inline uint16_t usToTicks(uint16_t us)
     return (clockCyclesPerMicrosecond() * us) / 8;
 }
 
-static constexpr uint16_t TRIM_DURATION = 2;  // compensation ticks to trim adjust for digitalWrite delays // 12 August 2009
+static constexpr uint16_t TRIM_DURATION = 2;  // sequential mode: compensation [us] for digitalWrite delays // 12 August 2009
 static constexpr uint16_t MIN_PULSE_WIDTH = 544;  // the shortest pulse sent to a pwm
 static constexpr uint16_t MAX_PULSE_WIDTH = 2400;  // the longest pulse sent to a pwm
 static constexpr uint16_t DEFAULT_PULSE_WIDTH = 1500;  // default pulse width when pwm is attached
-static constexpr uint16_t REFRESH_INTERVAL = 25000;  // minumim time to refresh PWM train in microseconds
+// minumim time to refresh PWM train in microseconds; sequential trains start with each control frame (runNow), so
+// this only paces them while no receiver frames arrive
+static constexpr uint16_t REFRESH_INTERVAL = 25000;
 static constexpr uint16_t INVALID_SERVO = 255;  // flag indicating an invalid pwm index
+// simultaneous mode: period of the trains [us]; at least the longest pulse plus the low time ESCs need
+static constexpr uint16_t TRAIN_INTERVAL = 5000;
+// simultaneous mode: trains repeated without runNow() until needsToRun(), and until they stop
+static constexpr uint8_t REFRESH_REPEATS = REFRESH_INTERVAL / TRAIN_INTERVAL;
+static constexpr uint8_t HOLD_REPEATS = 2 * REFRESH_REPEATS;
+// ticks (8 us); edges closer than this to the current one are ended in the same ISR, each at its own tick
+static constexpr uint16_t EDGE_GUARD = 16;
+// ticks (4 us, about the interrupt latency); the compare fires this early, the ISR then waits for the exact tick
+static constexpr uint16_t ISR_LEAD = 8;
+static_assert(ISR_LEAD < EDGE_GUARD, "the next compare must be ahead of the count");
 
 uint8_t RcPwm::_pwm_count = 0;
 volatile int8_t RcPwm::_counter = 0;
 volatile bool RcPwm::_needs_run = false;
 RcPwm::Pwm RcPwm::_pwms[MAX_PWM_COUNT];
+RcPwm::Mode RcPwm::_mode = RcPwm::Mode::Sequential;
+volatile bool RcPwm::_stopped = false;
+volatile uint8_t RcPwm::_repeats = 0;
+RcPwm::Edge RcPwm::_edges[2][MAX_PWM_COUNT];
+uint8_t RcPwm::_edge_count[2] = {0, 0};
+RcPwm::Port RcPwm::_ports[2][MAX_PWM_COUNT];
+uint8_t RcPwm::_port_count[2] = {0, 0};
+uint8_t RcPwm::_active_edges = 0;
+volatile bool RcPwm::_edges_changed = false;
 
 
 RcPwm::RcPwm()
@@ -67,6 +89,7 @@ uint8_t RcPwm::attach(int pin)
         }
 
         _pwms[_index].pin.is_active = true; // this must be set after the check for isTimerActive
+        buildEdges();
     }
     return _index;
 }
@@ -74,28 +97,57 @@ uint8_t RcPwm::attach(int pin)
 void RcPwm::detach()
 {
     _pwms[_index].pin.is_active = false;
+    buildEdges();
+}
+
+void RcPwm::setMode(Mode mode)
+{
+    uint8_t oldSREG = SREG;
+    cli();
+
+    // only switch between trains
+    if (_counter >= 0)
+    {
+        _counter = -1;
+        for (uint8_t c = 0; c < _pwm_count; ++c)
+        {
+            if (_pwms[c].pin.is_active)
+            {
+                digitalWrite(_pwms[c].pin.pin_index, LOW);
+            }
+        }
+    }
+
+    _mode = mode;
+    SREG = oldSREG;
 }
 
 void RcPwm::writeMicroseconds(uint16_t us)
 {
+    PROFILE(PwmWrite);
+
     // calculate and store the values for the given channel
     byte channel = _index;
     if ((channel < MAX_PWM_COUNT)) // ensure channel is valid
     {
         us = estd::clamp(us, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
-        us -= TRIM_DURATION;
         auto ticks = usToTicks(us);
 
+        if (ticks == _pwms[channel].ticks)
+            return;
+
         uint8_t oldSREG = SREG;
         cli();
         _pwms[channel].ticks = ticks;
         SREG = oldSREG;
+
+        buildEdges();
     }
 }
 
 uint16_t RcPwm::readMicroseconds() const
 {
-    return _index != INVALID_SERVO ? ticksToUs(_pwms[_index].ticks) + TRIM_DURATION : 0;
+    return _index != INVALID_SERVO ? ticksToUs(_pwms[_index].ticks) : 0;
 }
 
 bool RcPwm::attached() const
@@ -104,6 +156,20 @@ bool RcPwm::attached() const
 }
 
 void RcPwm::runImpl(bool start)
+{
+    PROFILE(PwmRun);
+
+    if (_mode == Mode::Simultaneous)
+    {
+        runSimultaneous(start);
+    }
+    else
+    {
+        runSequential(start);
+    }
+}
+
+void RcPwm::runSequential(bool start)
 {
     if (_counter < 0)
     {
@@ -129,7 +195,7 @@ void RcPwm::runImpl(bool start)
 
     if (_counter < _pwm_count && _counter < MAX_PWM_COUNT)
     {
-        OCR1A = TCNT1 + _pwms[_counter].ticks;
+        OCR1A = TCNT1 + _pwms[_counter].ticks - usToTicks(TRIM_DURATION);
 
         if (_pwms[_counter].pin.is_active)
         {
@@ -154,17 +220,167 @@ void RcPwm::runImpl(bool start)
     }
 }
 
+void RcPwm::runSimultaneous(bool start)
+{
+    if (_counter < 0)
+    {
+        if (!start)
+        {
+            // next train due: repeat the last values, ask the main loop for a refresh as the sequential mode does,
+            // and stop once it no longer calls runNow() (also after stop(), if its compare was already pending)
+            uint8_t repeats = _repeats + 1;
+            _repeats = repeats;
+            if (repeats % REFRESH_REPEATS == 0)
+            {
+                _needs_run = true;
+            }
+            if (repeats > HOLD_REPEATS || _stopped)
+            {
+                TCCR1B = 0;
+                return;
+            }
+        }
+
+        // pick up the latest lists; buildEdges() withdraws them while rewriting
+        if (_edges_changed)
+        {
+            _active_edges ^= 1;
+            _edges_changed = false;
+        }
+
+        // raise all channels with one write per port, then start the train: the pulses start together
+        const Port* ports = _ports[_active_edges];
+        for (uint8_t i = 0; i < _port_count[_active_edges]; ++i)
+        {
+            *ports[i].out |= ports[i].mask;
+        }
+
+        TCNT1 = 0;
+        TCCR1B = _BV(CS11); // run with pre-scaler 8
+        _counter = 0;
+    }
+    else
+    {
+        // end the due pulse and any ending before the compare interrupt could fire again; never before its tick
+        const Edge* edges = _edges[_active_edges];
+        while (_counter < _edge_count[_active_edges] && edges[_counter].ticks <= TCNT1 + EDGE_GUARD)
+        {
+            while (TCNT1 < edges[_counter].ticks)
+            {
+            }
+            *edges[_counter].out &= ~edges[_counter].mask;
+            ++_counter;
+        }
+    }
+
+    if (_counter < _edge_count[_active_edges])
+    {
+        OCR1A = _edges[_active_edges][_counter].ticks - ISR_LEAD;
+    }
+    else
+    {
+        // wait for the next train
+        if (static_cast<unsigned>(TCNT1) + 4 < usToTicks(TRAIN_INTERVAL))
+        {
+            OCR1A = static_cast<unsigned>(usToTicks(TRAIN_INTERVAL));
+        }
+        else
+        {
+            OCR1A = TCNT1 + 4;
+        }
+
+        _counter = -1;
+    }
+}
+
+void RcPwm::buildEdges()
+{
+    // the ISR may start a train and switch lists at any time: withdraw the inactive lists while they are rewritten
+    uint8_t oldSREG = SREG;
+    cli();
+    _edges_changed = false;
+    uint8_t next = _active_edges ^ 1;
+    SREG = oldSREG;
+
+    // insertion sort of the active channels by width into the inactive list; stable, so equal widths keep the
+    // channel order
+    Edge* edges = _edges[next];
+    Port* ports = _ports[next];
+    uint8_t count = 0;
+    uint8_t port_count = 0;
+
+    for (uint8_t c = 0; c < _pwm_count; ++c)
+    {
+        if (!_pwms[c].pin.is_active)
+            continue;
+
+        uint8_t pin = _pwms[c].pin.pin_index;
+        PortRegister out = portOutputRegister(digitalPinToPort(pin));
+        uint8_t mask = digitalPinToBitMask(pin);
+
+        uint16_t ticks = _pwms[c].ticks;
+        uint8_t i = count++;
+        for (; i > 0 && edges[i - 1].ticks > ticks; --i)
+        {
+            edges[i] = edges[i - 1];
+        }
+        edges[i] = {ticks, out, mask};
+
+        uint8_t p = 0;
+        while (p < port_count && ports[p].out != out)
+        {
+            ++p;
+        }
+        if (p == port_count)
+        {
+            ports[port_count++] = {out, 0};
+        }
+        ports[p].mask |= mask;
+    }
+
+    _edge_count[next] = count;
+    _port_count[next] = port_count;
+    _edges_changed = true;
+}
+
 bool RcPwm::needsToRun()
 {
     return _needs_run;
 }
 
+void RcPwm::stop()
+{
+    uint8_t oldSREG = SREG;
+    cli();
+
+    _stopped = true;
+    TCCR1B = 0;  // stop the timer, no further compare interrupts
+    _counter = -1;
+    _needs_run = false;
+
+    for (uint8_t c = 0; c < _pwm_count; ++c)
+    {
+        if (_pwms[c].pin.is_active)
+        {
+            digitalWrite(_pwms[c].pin.pin_index, LOW);
+        }
+    }
+
+    SREG = oldSREG;
+}
+
 void RcPwm::runNow()
 {
     uint8_t oldSREG = SREG;
     cli();
 
-    runImpl(true);
+    // start a train unless one is running (starting would end its pulses early) or, in simultaneous mode, the ISR
+    // already repeats them: its timer only stops with the trains
+    if (!_stopped && _counter < 0 && (_mode == Mode::Sequential || TCCR1B == 0))
+    {
+        runImpl(true);
+    }
+    _repeats = 0;
     _needs_run = false;
 
     SREG = oldSREG;
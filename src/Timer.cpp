@@ -0,0 +1,8 @@
+#include "Timer.h"
+#include <avr/interrupt.h>
+
+// Interrupt Service Routine (ISR) for when Timer2's counter overflows; this will occur every 128us
+ISR(TIMER2_OVF_vect)  // Timer2's counter has overflowed
+{
+    Timer::instance().increment_overflow_count();  // increment the timer2 overflow counter
+}
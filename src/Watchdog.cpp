@@ -0,0 +1,67 @@
+#include "Watchdog.h"
+#include <avr/interrupt.h>
+
+static constexpr uint32_t EXPIRED_MAGIC = 0x5741544bUL;  // "WATK"
+
+// not cleared by the C runtime, so they survive the watchdog reset
+static uint32_t expired_marker __attribute__((section(".noinit")));
+static uint8_t saved_mcusr __attribute__((section(".noinit")));
+
+Watchdog::Handler Watchdog::_on_expiry = nullptr;
+volatile bool Watchdog::_expired = false;
+bool Watchdog::_caused_reset = false;
+
+// After a watchdog reset WDRF keeps the watchdog enabled at its shortest timeout (15 ms), which resets again before
+// setup() is reached unless something stops it first. This runs right after the stack is set up, before the C runtime
+// initializes RAM: save the reset cause and stop the watchdog. On the host it is a plain function the tests call to
+// simulate a reset.
+#ifdef __AVR__
+void watchdog_init3() __attribute__((naked, used, section(".init3")));
+#else
+void watchdog_init3();
+#endif
+void watchdog_init3()
+{
+    saved_mcusr = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+void Watchdog::setup(uint8_t timeout, Handler on_expiry)
+{
+    // the marker is random after power-up; MCUSR may have been cleared by a bootloader (Optiboot)
+    bool power_on = saved_mcusr & bit(PORF);
+    _caused_reset = (saved_mcusr & bit(WDRF)) || (!power_on && expired_marker == EXPIRED_MAGIC);
+    expired_marker = 0;
+
+    _on_expiry = on_expiry;
+    _expired = false;
+
+    uint8_t prescaler = (timeout & 0x07) | ((timeout & 0x08) ? bit(WDP3) : 0);
+
+    uint8_t SREG_old = SREG;
+    noInterrupts();
+
+    wdt_reset();
+    WDTCSR = bit(WDCE) | bit(WDE);  // timed sequence: the new value must be written within 4 cycles
+    WDTCSR = bit(WDIE) | bit(WDE) | prescaler;  // interrupt first, then reset
+
+    SREG = SREG_old;
+}
+
+void Watchdog::expire()
+{
+    // the hardware cleared WDIE, so the next timeout resets
+    _expired = true;
+    expired_marker = EXPIRED_MAGIC;
+
+    if (_on_expiry)
+    {
+        _on_expiry();
+    }
+}
+
+ISR(WDT_vect)
+{
+    Watchdog::expire();
+}
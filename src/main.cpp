@@ -1,11 +1,26 @@
 #include "Motor.h"
 #include "Gyro.h"
+#include "PinChange.h"
 #include "RcChannel.h"
 #include "Timer.h"
 #include "eeprom_util.h"
 #include "LedGauge.h"
+#include "YawController.h"
+#include "Heading.h"
+#include "Battery.h"
+#include "PowerMonitor.h"
+#include "ThrustCurve.h"
+#include "HoverStates.h"
+#include "SeqLock.h"
+#include "Scheduler.h"
+#include "Profile.h"
+#include "Tachometer.h"
+#include "SlipEstimator.h"
+#include "Startup.h"
+#include "I2cBus.h"
+#include "Watchdog.h"
+#include "Mixer.h"
 #include <Arduino.h>
-#include <Adafruit_INA219.h>
 #include <estd/algorithm.h>
 
 constexpr uint8_t PIN_RX_DIR = 2;
@@ -15,10 +30,17 @@ constexpr uint8_t PIN_TX_HOVER = 11;
 constexpr uint8_t PIN_TX_LEFT_FAN = 7;
 constexpr uint8_t PIN_TX_RIGHT_FAN = 8;
 constexpr uint8_t PIN_NEOPIXEL = 6;
+constexpr uint8_t PIN_TACH_LEFT = A0;
+constexpr uint8_t PIN_TACH_RIGHT = A1;
+constexpr uint8_t TACH_PULSES_PER_REV = 7;  // ESC RPM output: one pulse per electrical revolution, 14-pole motors
+constexpr uint8_t INA219_ADDRESS = 0x44;
+constexpr uint16_t SHUNT_MOHM = 100;
+
+// control cycles come at least every PWM refresh (25 ms); a stall of 120 ms stops the outputs, 240 ms resets
+constexpr uint8_t WATCHDOG_TIMEOUT = WDTO_120MS;
 
 // all in microseconds
-constexpr int16_t FAIL_SAFE_TIMEOUT_US = 1000;
-constexpr uint32_t INIT_TIME_US = 3000000;
+constexpr uint32_t FAIL_SAFE_TIMEOUT_US = 100000;
 constexpr int16_t DEAD_ZONE = 10;
 constexpr int16_t DIR_CENTER = 1500;
 constexpr int16_t HOVER_MID_VALUE = 1500;
@@ -33,104 +55,236 @@ constexpr int16_t ZERO_LEFT_FAN = 1470;
 constexpr int16_t ZERO_RIGHT_FAN = 1477;
 constexpr int16_t HOVER_DEFAULT_VAL = 1100;
 constexpr int16_t HOVER_FAILSAFE_VALUE = 1030;
+constexpr int16_t YAW_LIMIT_US = 400;
+constexpr int16_t HEADING_HOLD_GESTURE = 300;
+
+// commanded yaw rate per us of steering deflection [gyro units / us, Q6]
+constexpr int16_t YAW_RATE_PER_US = 96;
+
+// heading hold: commanded yaw rate per binary angle unit of heading error is 1/16, limited to YAW_RATE_LIMIT
+constexpr int16_t HEADING_GAIN_SHIFT = 4;
+constexpr int16_t YAW_RATE_LIMIT = 400;
+
+// yaw rate set-point limit [gyro units]: the rate commanded by full stick deflection (500 us)
+constexpr int16_t YAW_SETPOINT_LIMIT = (500L * YAW_RATE_PER_US) / 64;
+
+// slip compensation: counter-yaw of 1/2^SLIP_YAW_SHIFT gyro units per mm/s of lateral velocity (1/8: 2 LSB), above
+// SLIP_MIN_SPEED forward speed
+constexpr bool SLIP_COMPENSATION = true;
+constexpr uint8_t SLIP_YAW_SHIFT = 3;
+constexpr int16_t SLIP_YAW_LIMIT = Gyro::zUnits(20);  // [gyro units]
+constexpr int16_t SLIP_MIN_SPEED = 500;  // [mm/s]
 
-uint32_t init_time = 0;
 bool fail_safe = false;
-bool init_done = false;
 volatile bool rx_done = false;
 int16_t int_count = 0;
 int16_t hover_val = HOVER_DEFAULT_VAL;
+int16_t hover_ref_mv = 0;  // terminal voltage hover_val was tuned at; 0 if unknown
 const Range range = {MIN_VAL, MAX_VAL};
 const Range thrust_range = {1020, 1980};
 Motor left_motor(PIN_TX_LEFT_FAN, thrust_range);
 Motor right_motor(PIN_TX_RIGHT_FAN, thrust_range);
 Motor hover_motor(PIN_TX_HOVER, range);
-RcChannel thrust_channel_rx(PIN_RX_THRUST, DIR_CENTER);
-RcChannel dir_channel_rx(PIN_RX_DIR, DIR_CENTER);
-RcChannel hover_channel_rx(PIN_RX_HOVER, MIN_VAL);
+
+// mixer outputs, in the order of MIXER_ROWS
+enum MixerOutput : uint8_t
+{
+    MIX_RIGHT_FAN,
+    MIX_LEFT_FAN,
+    MIX_HOVER_FAN,
+    MIX_COUNT
+};
+
+// weights (Q6) for thrust, yaw and hover; trim, limits [us]
+constexpr MixerRow MIXER_ROWS[MIX_COUNT] = {
+    {64, -64, 0, ZERO_RIGHT_FAN, 1020, 1980},
+    {64, 64, 0, ZERO_LEFT_FAN, 1020, 1980},
+    {0, 0, 64, ZERO_HOVER_FAN, MIN_VAL, MAX_VAL},
+};
+typedef Mixer<MIX_COUNT, MIXER_ROWS> HoverMixer;
+RcChannel thrust_channel_rx(PIN_RX_THRUST, DIR_CENTER * COUNT_PER_MICROS);
+RcChannel dir_channel_rx(PIN_RX_DIR, DIR_CENTER * COUNT_PER_MICROS);
+RcChannel hover_channel_rx(PIN_RX_HOVER, MIN_VAL * COUNT_PER_MICROS);
 Gyro gyro;
 LedGauge gauge(PIN_NEOPIXEL);
-Adafruit_INA219 ina(0x44);
-bool is3s = false;
-
-enum class State
+PowerMonitor power_monitor(INA219_ADDRESS, SHUNT_MOHM);
+I2cBus i2c_bus;
+YawController yaw_controller({32, 2, 8, 64}, YAW_LIMIT_US);
+Battery battery;
+Tachometer left_tach(PIN_TACH_LEFT, TACH_PULSES_PER_REV);
+Tachometer right_tach(PIN_TACH_RIGHT, TACH_PULSES_PER_REV);
+ThrustCurve left_curve;
+ThrustCurve right_curve;
+Heading heading;
+SlipEstimator slip;
+bool heading_hold = false;
+bool heading_locked = false;
+uint16_t heading_target = 0;
+
+// one complete receiver frame as published by the PCINT ISR
+constexpr uint8_t RX_CHANNELS = 3;
+
+struct RxFrame
 {
-    Init,
-    Calibration,
-    Idle,
-    Hover,
-    FailSafe,
-    Tune
+    uint16_t pulse[RX_CHANNELS];  // [timer counts]
+    uint8_t fresh;  // bit per channel: pulse received during this frame
 };
 
-State state = State::Init;
+RcChannel* const rx_channels[RX_CHANNELS] = {&thrust_channel_rx, &dir_channel_rx, &hover_channel_rx};
+SeqLock<RxFrame> rx_frames;
 
-struct RxData
+// RC channel edge handlers, called from the pin change ISRs
+void on_thrust_edge(bool high, uint32_t now)
 {
-    int16_t thrust_us;
-    int16_t dir_us;
-    int16_t hover_us;
-};
+    if (thrust_channel_rx.rx(high, now))
+    {
+        // DIR pulse starts where the THRUST pulse ends
+        dir_channel_rx.start(now);
+    }
+}
 
-void setup()
+void on_dir_edge(bool high, uint32_t now)
+{
+    dir_channel_rx.rx(high, now);
+}
+
+void on_hover_edge(bool high, uint32_t now)
+{
+    // hover is the last channel of the frame: publish the complete frame
+    if (hover_channel_rx.rx(high, now))
+    {
+        RxFrame frame;
+        frame.fresh = 0;
+        for (uint8_t i = 0; i < RX_CHANNELS; ++i)
+        {
+            if (rx_channels[i]->take(frame.pulse[i]))
+            {
+                frame.fresh |= bit(i);
+            }
+        }
+
+        rx_frames.write(frame);
+        rx_done = true;
+    }
+}
+
+void setup_tasks();
+
+// the control loop stalled: stop all pulses, the ESCs then shut off the motors
+void on_watchdog_expiry()
 {
-    init_done = false;
-    init_time = micros();
+    RcPwm::stop();
+}
 
-    Serial.begin(9600);
-    Serial.println("Timo's HoverCraft");
+void setup()
+{
+    Serial.begin(115200);  // keeps the configuration messages from blocking startup
+    Serial.println(F("Timo's HoverCraft"));
 
-    Serial.println("\nConfiguring...");
+    Serial.println(F("\nConfiguring..."));
 
-    Serial.println("- Pixels");
+    Serial.println(F("- Pixels"));
     gauge.setup();
 
-    Serial.println("- Gyro");
+    Serial.println(F("- Gyro"));
     gyro.setup();
+    gyro.enableMotion(SLIP_COMPENSATION);
 
-    Serial.println("- Left Motor");
+    Serial.println(F("- Left Motor"));
+    RcPwm::setMode(RcPwm::Mode::Simultaneous);  // trains at 200 Hz, the pulses start together
     left_motor.setup();
 
-    Serial.println("- Right Motor");
+    Serial.println(F("- Right Motor"));
     right_motor.setup();
 
-    Serial.println("- Hover Motor");
+    Serial.println(F("- Hover Motor"));
     hover_motor.setup();
 
-    Serial.println("- Thrust PWM");
-    thrust_channel_rx.setup();
+    Serial.println(F("- Fan tachometers"));
+    left_tach.setup();
+    right_tach.setup();
+    left_motor.setTachometer(&left_tach);
+    right_motor.setTachometer(&right_tach);
 
-    Serial.println("- Steering PWM");
-    dir_channel_rx.setup();
+    Serial.println(F("- Thrust PWM"));
+    thrust_channel_rx.setup(on_thrust_edge);
 
-    Serial.println("- Hover PWM");
-    hover_channel_rx.setup();
+    Serial.println(F("- Steering PWM"));
+    dir_channel_rx.setup(on_dir_edge);
 
-    Serial.println("- Timer");
+    Serial.println(F("- Hover PWM"));
+    hover_channel_rx.setup(on_hover_edge);
+
+    Serial.println(F("- Timer"));
     Timer::instance().setup();
+    heading.restart(Timer::instance().get_count());
 
-    Serial.println("- Voltage measurement");
-    ina.begin();
-}
+    Serial.println(F("- Voltage measurement"));
+    power_monitor.setup();
 
-// pin change interrupt for receiving RC signals
-ISR(PCINT2_vect)  // handle pin change interrupt for D0 to D7 here
-{
-    auto pind = PIND;
-    auto cnt = Timer::instance().get_count();
+    // fast mode for the 14 byte motion burst, with bounded transactions
+    i2c_bus.setup();
+
+    setup_tasks();
 
-    if (thrust_channel_rx.rx(pind, cnt))
+    Serial.println(F("- Watchdog"));
+    Watchdog::setup(WATCHDOG_TIMEOUT, on_watchdog_expiry);
+    if (Watchdog::caused_reset())
     {
-        // force rising edge of DIR
-        pind |= bit(PIN_RX_DIR);
+        Serial.println(F("  restarted by watchdog"));
     }
+}
 
-    dir_channel_rx.rx(pind, cnt);
-    rx_done = hover_channel_rx.rx(pind, cnt);
+// pin change interrupts for receiving RC signals, on any port
+ISR(PCINT0_vect)  // D8 to D13
+{
+    PROFILE(RcRx);
+    PinChange::dispatch(0, PINB, Timer::instance().get_count());
+}
+
+ISR(PCINT2_vect)  // D0 to D7
+{
+    PROFILE(RcRx);
+    PinChange::dispatch(2, PIND, Timer::instance().get_count());
+}
+
+// the fan tachometers: ESC frequency outputs of some kHz each, which fire the interrupt on both edges; it returns on
+// the falling ones after the level check, and counts the rising ones inline, without a handler call
+ISR(PCINT1_vect)  // A0 to A5
+{
+    uint8_t rising = PinChange::rising(1, PINC);
+    if (rising == 0)
+        return;
+
+    uint32_t now = Timer::instance().get_count();
+    left_tach.edges(rising, now);
+    right_tach.edges(rising, now);
 }
 
 RxData read_rc_inputs()
 {
+    static uint8_t last_seq = 0;
+    auto now = Timer::instance().get_count();
+
+    // consistent snapshot of the last frame, no interrupt lock
+    RxFrame frame;
+    auto seq = rx_frames.read(frame);
+    if (seq != last_seq)
+    {
+        last_seq = seq;
+
+        for (uint8_t i = 0; i < RX_CHANNELS; ++i)
+        {
+            rx_channels[i]->update(frame.pulse[i], (frame.fresh & bit(i)) != 0, now);
+        }
+    }
+
+    // every control cycle, also without frames: PWM refreshes run it at least every 25 ms
+    for (uint8_t i = 0; i < RX_CHANNELS; ++i)
+    {
+        rx_channels[i]->expire(now);
+    }
+
     RxData rx;
     rx.thrust_us = thrust_channel_rx.pulse_length() / COUNT_PER_MICROS;
     rx.dir_us = dir_channel_rx.pulse_length() / COUNT_PER_MICROS;
@@ -145,6 +299,8 @@ RxData read_rc_inputs()
  */
 int16_t calculate_damping_factor(const RxData& rxData)
 {
+    PROFILE(Damping);
+
     using estd::min;
 
     int16_t dir_damping_factor; // 0 .. 32 (full .. no steering)
@@ -168,163 +324,281 @@ int16_t calculate_damping_factor(const RxData& rxData)
 
 void handle_hover_state(const RxData& rxData, int16_t gyro_z)
 {
-    hover_motor.set(hover_val);
+    PROFILE(Hover);
 
     // directional component from steering
     auto dir_steering = (rxData.dir_us - DIR_CENTER);
 
-    // directional component from thrust
-    auto dir_thrust = rxData.thrust_us;
+    // directional component from thrust, limited when the battery runs low
+    int16_t dir_thrust = (static_cast<int32_t>(rxData.thrust_us - DIR_CENTER) * battery.throttleLimit()) >> 8;
 
-    // directional component from gyro
+    // yaw-rate control: steering is the rate set-point (and feed-forward), gyro the measurement;
+    // a positive stick deflection yields a negative gyro reading
     auto gyro_damping_factor = calculate_damping_factor(rxData);
-    auto dir_gyro = (gyro_z * ((gyro_damping_factor / 2) + 16)) / 64;
+    int16_t yaw_setpoint = (static_cast<int32_t>(dir_steering) * YAW_RATE_PER_US) / 64;
 
-    // calculate set-point value
-    auto right_us = dir_thrust - (dir_steering + dir_gyro);
-    auto left_us = dir_thrust + (dir_steering + dir_gyro);
-
-    // compensate for battery type
-    if (is3s)
+    // heading hold: with the stick centred, steer back to the heading captured when it was released
+    if (heading_hold && abs(dir_steering) <= DEAD_ZONE)
     {
-        right_us = ((right_us - DIR_CENTER) / 2) + DIR_CENTER;
-        left_us = ((left_us - DIR_CENTER) / 2) + DIR_CENTER;
+        if (!heading_locked)
+        {
+            heading_target = heading.value();
+            heading_locked = true;
+        }
+
+        // heading grows with gyro_z, which is the opposite of the stick direction
+        int16_t heading_error = static_cast<int16_t>(heading_target - heading.value());
+        int16_t heading_rate = -(heading_error >> HEADING_GAIN_SHIFT);
+        yaw_setpoint = estd::clamp(heading_rate, static_cast<int16_t>(-YAW_RATE_LIMIT), YAW_RATE_LIMIT);
     }
     else
     {
-        right_us = (((right_us - DIR_CENTER) * 3) / 4) + DIR_CENTER;
-        left_us = (((left_us - DIR_CENTER) * 3) / 4) + DIR_CENTER;
+        heading_locked = false;
+    }
+
+    // counter-yaw against lateral slide: turning towards the slide points the thrust against it, so the craft
+    // tracks the stick instead of sliding out of turns (left slide, positive lateral, needs a right turn)
+    if (SLIP_COMPENSATION && !heading_locked && abs(slip.longitudinal()) >= SLIP_MIN_SPEED)
+    {
+        int16_t counter_yaw = slip.counterYaw(SLIP_YAW_SHIFT, SLIP_YAW_LIMIT);
+        yaw_setpoint = estd::clamp(static_cast<int16_t>(yaw_setpoint + counter_yaw),
+            static_cast<int16_t>(-YAW_SETPOINT_LIMIT), static_cast<int16_t>(YAW_SETPOINT_LIMIT));
+    }
+
+    // slowly refine the gyro bias while going straight without steering input
+    if (abs(dir_steering) <= DEAD_ZONE)
+    {
+        gyro.updateBias(Gyro::BIAS_SHIFT_HOVER);
+    }
+
+    auto dir_yaw = yaw_controller.update(dir_steering, yaw_setpoint, -gyro_z, gyro_damping_factor);
+
+    // hover fan command compensated for battery sag
+    int16_t hover_us = battery.compensate(hover_val, ZERO_HOVER_FAN, hover_ref_mv);
+    const MixerInput input = {dir_thrust, dir_yaw, static_cast<int16_t>(hover_us - ZERO_HOVER_FAN)};
+
+    hover_motor.set(HoverMixer::output<MIX_HOVER_FAN>(HoverMixer::mix<MIX_HOVER_FAN>(input)));
+
+    // linearise thrust (table selected for battery type), then apply the fan trim
+    int16_t right_offset = right_curve.toMicroseconds(HoverMixer::mix<MIX_RIGHT_FAN>(input));
+    int16_t left_offset = left_curve.toMicroseconds(HoverMixer::mix<MIX_LEFT_FAN>(input));
+    int16_t right_us = HoverMixer::output<MIX_RIGHT_FAN>(right_offset);
+    int16_t left_us = HoverMixer::output<MIX_LEFT_FAN>(left_offset);
+
+    // fan speed matching: split the measured total speed in proportion to the commanded offsets, so each fan is
+    // trimmed towards the speed its command implies for the pair; open loop without tachometer signals
+    static constexpr int16_t MIN_SPEED_CONTROL_OFFSET = 40;
+    uint16_t right_rpm = 0;
+    uint16_t left_rpm = 0;
+    uint16_t total_offset = abs(right_offset) + abs(left_offset);
+    if (left_tach.running() && right_tach.running() && total_offset >= MIN_SPEED_CONTROL_OFFSET)
+    {
+        uint32_t total_rpm = static_cast<uint32_t>(left_tach.rpm()) + right_tach.rpm();
+        right_rpm = static_cast<uint16_t>((total_rpm * abs(right_offset)) / total_offset);
+        left_rpm = static_cast<uint16_t>((total_rpm * abs(left_offset)) / total_offset);
     }
-    
-    // apply steering trim
-    right_us += ZERO_LEFT_FAN - DIR_CENTER;
-    left_us += ZERO_RIGHT_FAN - DIR_CENTER;
 
     static constexpr int16_t MAX_DELTA = 50;
-    right_motor.setFiltered(right_us, ZERO_RIGHT_FAN, MAX_DELTA);
-    left_motor.setFiltered(left_us, ZERO_LEFT_FAN, MAX_DELTA);
+    right_motor.setRpm(right_rpm, right_us, HoverMixer::trim<MIX_RIGHT_FAN>(), MAX_DELTA);
+    left_motor.setRpm(left_rpm, left_us, HoverMixer::trim<MIX_LEFT_FAN>(), MAX_DELTA);
 }
 
-void update_state_machine(const RxData& rxData, int16_t gyro_z)
+// cooperative tasks, in priority order
+enum Task : uint8_t
 {
-    fail_safe = rxData.dir_us > 2 * MAX_VAL;
+    TASK_CONTROL,
+    TASK_GAUGE,
+    TASK_BATTERY,
+    TASK_TELEMETRY,
+    TASK_COUNT
+};
 
-    bool hover_rx_high = rxData.hover_us > HOVER_MID_VALUE;
-    static bool hover_rx_was_high = hover_rx_high;
-    bool toggle_hover = hover_rx_high != hover_rx_was_high;
-    hover_rx_was_high = hover_rx_high;
+// pixel updates block interrupts, so the gauge only runs in the quiet gap after a receiver frame, or not at all
+constexpr uint32_t GAUGE_WINDOW = 1000UL * COUNT_PER_MICROS;
+constexpr uint32_t CONTROL_DEADLINE = 2000UL * COUNT_PER_MICROS;
+constexpr uint32_t CONTROL_BUDGET = 4000UL * COUNT_PER_MICROS;  // run time per control frame
+constexpr uint32_t BATTERY_PERIOD = 5000UL * COUNT_PER_MICROS;
+constexpr uint32_t TELEMETRY_DEADLINE = 25000UL * COUNT_PER_MICROS;
+
+// the idle sleep lasts at most one Timer2 overflow period, well within the control deadline
+static_assert(COUNT_PER_OVERFLOW < CONTROL_DEADLINE, "idle sleep exceeds control deadline");
+Scheduler<TASK_COUNT> scheduler;
+Frame control_frame;  // inputs of the last control cycle
+
+bool gyro_calibrated = false;
+
+// startup readiness conditions, all checked in parallel while in Init
+constexpr uint8_t READY_ESC_ARMED = bit(0);  // ESCs saw the arming signal for ESC_ARM_MS
+constexpr uint8_t READY_GYRO = bit(1);  // gyro settled and still
+constexpr uint8_t READY_BATTERY = bit(2);  // pack voltage measured and cells detected
+constexpr uint8_t READY_RECEIVER = bit(3);  // all RC channels deliver valid pulses
+constexpr uint8_t READY_ALL = READY_ESC_ARMED | READY_GYRO | READY_BATTERY | READY_RECEIVER;
+
+constexpr uint32_t ESC_ARM_MS = 1500;
+constexpr uint32_t STARTUP_TIMEOUT_MS = 3000;  // the former fixed init wait
 
-    bool tune = rxData.thrust_us > TUNE_VAL;
+Startup startup(READY_ALL, STARTUP_TIMEOUT_MS);
+uint32_t time_to_hover_ms = 0;  // time from reset to first hover, 0 until then
 
-    switch (state)
+// set thrust fans to zero and hover fan to hover_us
+void set_stopped_outputs(int16_t hover_us)
+{
+    hover_motor.set(hover_us);
+    left_motor.set(ZERO_LEFT_FAN);
+    right_motor.set(ZERO_RIGHT_FAN);
+}
+
+void enter_init(const Frame&)
+{
+    int16_t h = eeprom_read_int(EEPROM_HOVER_VALUE_ADDR);
+    if (h > MIN_VAL and h < MAX_VAL)
     {
-    case State::Init:
-        {
-            // detect battery
-            auto v = ina.getBusVoltage_V();
-            if (v > 9.0f)
-            {
-                is3s = true;
-            }
+        hover_val = h;
+        hover_ref_mv = eeprom_read_int(EEPROM_HOVER_VOLTAGE_ADDR);
+    }
 
-            int16_t h = eeprom_read_int(EEPROM_HOVER_VALUE_ADDR);
-            if (h > MIN_VAL and h < MAX_VAL)
-            {
-                hover_val = h;
-            }
+    right_motor.set(DIR_CENTER, false);
+    left_motor.set(DIR_CENTER, false);
+    hover_motor.set(INIT_VAL, false);
 
-            right_motor.set(DIR_CENTER, false);
-            left_motor.set(DIR_CENTER, false);
-            hover_motor.set(INIT_VAL, false);
-            if (micros() - init_time > INIT_TIME_US)
-            {
-                state = State::Idle;
-            }
-        }
-        break;
+    startup.start(millis());
+}
 
-    case State::Idle:
-        hover_motor.set(ZERO_HOVER_FAN);
-        left_motor.set(ZERO_LEFT_FAN);
-        right_motor.set(ZERO_RIGHT_FAN);
-        if (toggle_hover && !fail_safe)
-        {
-            if (!tune)
-            {
-                state = State::Hover;
-                // hover_motor.disable();
-                // left_motor.disable();
-                // right_motor.disable();
-            }
-            else
-            {
-                state = State::Calibration;
-            }
-        }
-        break;
+void run_init(const Frame&)
+{
+    uint32_t now = millis();
+    uint8_t ready = 0;
 
-    case State::Calibration:
-        gyro.calibrate();
-        state = State::Tune;
-        break;
+    if (startup.elapsed(now) >= ESC_ARM_MS)
+        ready |= READY_ESC_ARMED;
 
-    case State::Hover:
-        if (fail_safe)
-        {
-            state = State::FailSafe;
-        }
-        else if (toggle_hover)
-        {
-            state = State::Idle;
-        }
-        else
-        {
-            handle_hover_state(rxData, gyro_z);
-        }
-        break;
+    // gyro warm-up: refine the stored bias while still
+    gyro.updateBias(Gyro::BIAS_SHIFT_IDLE);
+    if (gyro.still())
+        ready |= READY_GYRO;
 
-    case State::FailSafe:
-        hover_motor.set(HOVER_FAILSAFE_VALUE);
-        left_motor.set(ZERO_LEFT_FAN);
-        right_motor.set(ZERO_RIGHT_FAN);
-        if (!fail_safe)
-        {
-            state = State::Hover;
-        }
-        break;
+    // detect battery (motors are not running yet, so this is the resting voltage)
+    if (battery.valid())
+    {
+        battery.detectCells();
+        left_curve.select(ThrustCurve::forCells(battery.cells()));
+        right_curve.select(ThrustCurve::forCells(battery.cells()));
+        ready |= READY_BATTERY;
+    }
 
-    case State::Tune:
-        if (fail_safe || toggle_hover || !tune)
-        {
-            state = State::Idle;
-            if (hover_val > HOVER_FAILSAFE_VALUE && hover_val < MAX_VAL)
-            {
-                eeprom_write(EEPROM_HOVER_VALUE_ADDR, hover_val);
-            }
-        }
-        else
-        {
-            hover_val = MIN_VAL + abs(rxData.dir_us - DIR_CENTER);
-            hover_motor.set(hover_val);
-        }
-        break;
+    if (!fail_safe)
+        ready |= READY_RECEIVER;
+
+    startup.update(ready, now);
+}
+
+void enter_idle(const Frame&) { set_stopped_outputs(ZERO_HOVER_FAN); }
+
+void run_idle(const Frame&) { gyro.updateBias(Gyro::BIAS_SHIFT_IDLE); }
+
+void enter_calibration(const Frame&)
+{
+    gyro_calibrated = false;
+    gyro.startCalibration();
+}
+
+void run_calibration(const Frame&)
+{
+    gyro_calibrated = gyro.calibrate();
+}
+
+void enter_hover(const Frame&)
+{
+    if (time_to_hover_ms == 0)
+    {
+        time_to_hover_ms = millis();
     }
+
+    yaw_controller.reset();
+    heading_locked = false;
+}
+
+void run_hover(const Frame& frame) { handle_hover_state(frame.rx, frame.gyro_z); }
+
+void enter_fail_safe(const Frame&) { set_stopped_outputs(HOVER_FAILSAFE_VALUE); }
+
+void run_tune(const Frame& frame)
+{
+    hover_val = MIN_VAL + abs(frame.rx.dir_us - DIR_CENTER);
+    hover_motor.set(hover_val);
 }
 
-const char* to_string(State state)
+void exit_tune(const Frame&)
 {
-    switch (state)
+    if (hover_val > HOVER_FAILSAFE_VALUE && hover_val < MAX_VAL)
     {
-    case State::Init: return "Init";
-    case State::Calibration: return "Calibration";
-    case State::Idle: return "Idle";
-    case State::Hover: return "Hover";
-    case State::Tune: return "Tune";
-    case State::FailSafe: return "FailSafe";
-    default: return "<invalid>";
+        hover_ref_mv = battery.terminalVoltage();
+        eeprom_write(EEPROM_HOVER_VALUE_ADDR, hover_val);
+        eeprom_write(EEPROM_HOVER_VOLTAGE_ADDR, hover_ref_mv);
     }
 }
 
+void select_heading_hold(const Frame& frame)
+{
+    heading_hold = abs(frame.rx.dir_us - DIR_CENTER) > HEADING_HOLD_GESTURE;
+}
+
+const char NAME_INIT[] PROGMEM = "Init";
+const char NAME_CALIBRATION[] PROGMEM = "Calibration";
+const char NAME_IDLE[] PROGMEM = "Idle";
+const char NAME_HOVER[] PROGMEM = "Hover";
+const char NAME_FAIL_SAFE[] PROGMEM = "FailSafe";
+const char NAME_TUNE[] PROGMEM = "Tune";
+
+// indexed by State
+const HoverStateMachine::StateInfo STATES[] PROGMEM = {
+    {NAME_INIT, enter_init, run_init, nullptr},
+    {NAME_CALIBRATION, enter_calibration, run_calibration, nullptr},
+    {NAME_IDLE, enter_idle, run_idle, nullptr},
+    {NAME_HOVER, enter_hover, run_hover, nullptr},
+    {NAME_FAIL_SAFE, enter_fail_safe, nullptr, nullptr},
+    {NAME_TUNE, nullptr, run_tune, exit_tune},
+};
+
+static_assert(sizeof(STATES) / sizeof(STATES[0]) == static_cast<uint8_t>(State::Count), "STATES out of sync");
+
+HoverStateMachine state_machine(STATES, TRANSITIONS, TRANSITION_COUNT, State::Init);
+
+void update_state_machine(const RxData& rxData, int16_t gyro_z)
+{
+    PROFILE(StateMachine);
+
+    // fail-safe unless every channel delivered a valid pulse recently
+    auto now = Timer::instance().get_count();
+    static constexpr uint32_t TIMEOUT = FAIL_SAFE_TIMEOUT_US * COUNT_PER_MICROS;
+    fail_safe = !thrust_channel_rx.valid(now, TIMEOUT) || !dir_channel_rx.valid(now, TIMEOUT) ||
+        !hover_channel_rx.valid(now, TIMEOUT);
+
+    bool hover_rx_high = rxData.hover_us > HOVER_MID_VALUE;
+    static bool hover_rx_was_high = hover_rx_high;
+    bool toggle_hover = hover_rx_high != hover_rx_was_high;
+    hover_rx_was_high = hover_rx_high;
+
+    uint8_t events = 0;
+    if (fail_safe)
+        events |= EVENT_FAIL_SAFE;
+    if (toggle_hover)
+        events |= EVENT_TOGGLE_HOVER;
+    if (rxData.thrust_us > TUNE_VAL)
+        events |= EVENT_TUNE;
+    if (startup.done())
+        events |= EVENT_INIT_DONE;
+    if (gyro_calibrated)
+        events |= EVENT_CALIBRATED;
+
+    state_machine.update(events, {rxData, gyro_z}, millis());
+}
+
+const __FlashStringHelper* to_string(State state)
+{
+    return state_machine.name(state);
+}
+
 template <typename T>
 void serial_print(const char* label, T value, char eol = '\t')
 {
@@ -333,8 +607,30 @@ void serial_print(const char* label, T value, char eol = '\t')
     Serial.print(eol);
 }
 
-float v = 0.0;
-float v_comp = 0.0;
+// label in flash (F("..."))
+template <typename T>
+void serial_print(const __FlashStringHelper* label, T value, char eol = '\t')
+{
+    Serial.print(label);
+    Serial.print(value);
+    Serial.print(eol);
+}
+
+/**
+ * Current draw per motor command, for runtime optimisation
+ *
+ * @return int16_t Current [mA] per 100 us of summed motor command above zero thrust
+ */
+int16_t current_per_command()
+{
+    int32_t command = abs(left_motor.value() - ZERO_LEFT_FAN) + abs(right_motor.value() - ZERO_RIGHT_FAN) +
+        (hover_motor.value() - ZERO_HOVER_FAN);
+
+    if (command <= 0)
+        return 0;
+
+    return static_cast<int16_t>((static_cast<int32_t>(power_monitor.current()) * 100) / command);
+}
 
 void serial_out(const RxData& rxData, int16_t gyro_z)
 {
@@ -346,76 +642,174 @@ void serial_out(const RxData& rxData, int16_t gyro_z)
 
     switch (k++)
     {
-    case 0: serial_print(" rxData.thr: ", rxData.thrust_us); break;
-    case 1: serial_print(" rxData.dir: ", rxData.dir_us); break;
-    case 2: serial_print(" rxData.hover: ", rxData.hover_us); break;
-    case 3: serial_print(" tx_r: ", right_motor.value()); break;
-    case 4: serial_print(" tx_l: ", left_motor.value()); break;
-    case 5: serial_print(" tx_hm: ", hover_motor.value()); break;
-    case 6: serial_print(" gz: ", gyro_z); break;
-    case 7: serial_print(" FS: ", fail_safe); break;
-    case 8: serial_print(" ST: ", to_string(state)); break;
-    case 9: serial_print(" HV: ", hover_val); break;
-    case 10: serial_print(" V: ", v); break;
-    case 11: serial_print(" Vc: ", v_comp); break;
+    case 0: serial_print(F(" rxData.thr: "), rxData.thrust_us); break;
+    case 1: serial_print(F(" rxData.dir: "), rxData.dir_us); break;
+    case 2: serial_print(F(" rxData.hover: "), rxData.hover_us); break;
+    case 3: serial_print(F(" tx_r: "), right_motor.value()); break;
+    case 4: serial_print(F(" tx_l: "), left_motor.value()); break;
+    case 5: serial_print(F(" tx_hm: "), hover_motor.value()); break;
+    case 6: serial_print(F(" gz: "), gyro_z); break;
+    case 7: serial_print(F(" FS: "), fail_safe); break;
+    case 8: serial_print(F(" ST: "), to_string(state_machine.state())); break;
+    case 9: serial_print(F(" HV: "), hover_val); break;
+    case 10: serial_print(F(" V: "), battery.voltage()); break;
+    case 11: serial_print(F(" Vc: "), battery.ocv()); break;
+    case 12: serial_print(F(" YI: "), yaw_controller.integral()); break;
+    case 13: serial_print(F(" HH: "), heading_hold); break;
+    case 14: serial_print(F(" HD: "), heading.degrees()); break;
+    case 15: serial_print(F(" GB: "), gyro.baseline()); break;
+    case 16: serial_print(F(" I: "), battery.current()); break;
+    case 17: serial_print(F(" R: "), battery.resistance()); break;
+    case 18: serial_print(F(" C: "), battery.charge()); break;
+    case 19: serial_print(F(" P: "), power_monitor.power()); break;
+    case 20: serial_print(F(" mAh: "), power_monitor.consumed()); break;
+    case 21: serial_print(F(" IpC: "), current_per_command()); break;
+    case 22: serial_print(F(" TS: "), state_machine.timeInState(millis())); break;
+    case 23: serial_print(F(" TC: "), state_machine.transitions()); break;
+    case 24:
+        serial_print(F(" GL: "), thrust_channel_rx.glitches() + dir_channel_rx.glitches() + hover_channel_rx.glitches());
+        break;
+    case 25: serial_print(F(" CPU: "), scheduler.utilisation()); break;
+    case 26: serial_print(F(" OV: "), scheduler.overruns()); break;
+    case 27: serial_print(F(" DC: "), scheduler.dutyCycle()); break;
+    case 28: serial_print(F(" RPMl: "), left_motor.rpm()); break;
+    case 29: serial_print(F(" RPMr: "), right_motor.rpm()); break;
+    case 30: serial_print(F(" TRl: "), left_motor.rpmTrim()); break;
+    case 31: serial_print(F(" TRr: "), right_motor.rpmTrim()); break;
+    case 32: serial_print(F(" VY: "), slip.lateral()); break;
+    case 33: serial_print(F(" SS: "), slip.sideslip()); break;
+    case 34: serial_print(F(" TR: "), startup.readyTime()); break;
+    case 35: serial_print(F(" TH: "), time_to_hover_ms); break;
+    case 36: serial_print(F(" NR: "), startup.missing()); break;
+    case 37: serial_print(F(" OVc: "), scheduler.overruns(TASK_CONTROL)); break;
+    case 38: serial_print(F(" CTm: "), scheduler.longest(TASK_CONTROL) / COUNT_PER_MICROS); break;
+    case 39: serial_print(F(" I2C: "), i2c_bus.timeouts()); break;
+    case 40: serial_print(F(" WD: "), Watchdog::caused_reset()); break;
+    case 41: serial_print(F(" PMr: "), power_monitor.retriggers()); break;
     default: k = 0; Serial.println(); break;
     }
 }
 
-void loop()
+// control cycle: RC inputs, gyro, state machine and motor outputs; released by each receiver frame
+void control_task()
 {
-    static uint32_t last_run = 0;
-    auto now = Timer::instance().get_count();
+    control_frame.rx = read_rc_inputs();
+    control_frame.gyro_z = gyro.read();
 
-    if (rx_done || RcPwm::needsToRun())
+    // a timed out read returned no valid sample: recover the bus and control with the last good one, without
+    // integrating slip and heading over it (their next update covers the gap)
+    if (i2c_bus.check())
     {
-        rx_done = false;
-        last_run = now;
+        control_frame.gyro_z = gyro.hold();
+    }
+    else
+    {
+        // slip is only integrated while hovering; on the ground the craft is at rest
+        if (SLIP_COMPENSATION && state_machine.state() == State::Hover)
+        {
+            slip.update(gyro.accelX(), gyro.accelY(), gyro.rate(), Timer::instance().get_count());
+        }
+        else if (SLIP_COMPENSATION)
+        {
+            slip.rest(gyro.accelX(), gyro.accelY(), Timer::instance().get_count());
+        }
+        heading.integrate(gyro.rate(), Timer::instance().get_count());
+    }
+    left_tach.update(Timer::instance().get_count());
+    right_tach.update(Timer::instance().get_count());
+    update_state_machine(control_frame.rx, control_frame.gyro_z);
 
-        auto rx_data = read_rc_inputs();
-        auto gyro_z = gyro.read();
-        update_state_machine(rx_data, gyro_z);
+    RcPwm::runNow();
+    Watchdog::kick();
 
-        RcPwm::runNow();
+    auto now = Timer::instance().get_count();
+    scheduler.release(TASK_GAUGE, now);
+    scheduler.release(TASK_TELEMETRY, now);
+}
 
-        v = ina.getBusVoltage_V();
+void gauge_task()
+{
+    PROFILE(Gauge);
 
-        serial_out(rx_data, gyro_z);
+    switch (state_machine.state())
+    {
+        case State::Init:
+            gauge.update(LedEffect::Rainbow);
+            break;
+
+        case State::Calibration:
+            gauge.update(LedEffect::Calibrating);
+            break;
+
+        case State::FailSafe:
+            gauge.update(LedEffect::FailSafe);
+            break;
+
+        case State::Tune:
+            gauge.update(LedEffect::Bars, (hover_motor.value() - ZERO_HOVER_FAN) / 50);
+            break;
+
+        default:
+            // below LOW_CHARGE the throttle is limited; the blinking gauge tells why
+            gauge.update(battery.charge() < Battery::LOW_CHARGE ? LedEffect::LowBattery : LedEffect::Charge,
+                battery.charge());
+            break;
     }
+}
 
-    if (now - last_run < COUNT_PER_MICROS * 1000)
+void battery_task()
+{
+    bool measured = power_monitor.poll(Timer::instance().get_count());
+
+    // a timed out transaction leaves an invalid measurement
+    if (!i2c_bus.check() && measured)
     {
-        //  0.45 mV voltage drop per hover tx - ZERO_HOVER_FAN
-        //  0.60 mV voltage drop per thrust tx
-        auto dv_l = abs(left_motor.value() - ZERO_LEFT_FAN) * 0.6e-3f;
-        auto dv_r = abs(right_motor.value() - ZERO_RIGHT_FAN) * 0.6e-3f;
-        auto dv_h = (hover_motor.value() - ZERO_HOVER_FAN) * 0.45e-3f;
-        v_comp = v + dv_l + dv_r + dv_h;
-        if (is3s)
-        {
-            v_comp *= 2.0f / 3.0f;
-        }
+        battery.update(power_monitor.voltage(), power_monitor.current());
+    }
+}
 
-        switch (state)
-        {
-            case State::Init:
-                gauge.rainbowCycle(5);
-                break;
-
-            case State::Tune:
-                {
-                    int bars = (hover_motor.value() - ZERO_HOVER_FAN) / 50;
-                    gauge.showBars(bars);
-                }
-                break;
-
-            case State::Hover:
-                gauge.showVoltage(v_comp);
-                break;
-
-            default:
-                gauge.showVoltage(v_comp);
-                break;
-        }
+void telemetry_task()
+{
+#ifdef HOVER_PROFILE
+    // the profile report replaces the regular telemetry
+    if (Serial.availableForWrite() >= 32)
+    {
+        Profile::report(Serial);
+    }
+#else
+    serial_out(control_frame.rx, control_frame.gyro_z);
+#endif
+}
+
+void setup_tasks()
+{
+    // in priority order, matching the Task ids
+    scheduler.add(control_task, 0, CONTROL_DEADLINE);
+    scheduler.add(gauge_task, 0, GAUGE_WINDOW, true);
+    scheduler.add(battery_task, BATTERY_PERIOD, BATTERY_PERIOD);
+    scheduler.add(telemetry_task, 0, TELEMETRY_DEADLINE);
+
+    scheduler.setBudget(TASK_CONTROL, CONTROL_BUDGET);
+}
+
+// wake condition of the idle sleep: a receiver frame or PWM refresh is due
+bool control_pending()
+{
+    return rx_done || RcPwm::needsToRun();
+}
+
+void loop()
+{
+    auto now = Timer::instance().get_count();
+
+    if (control_pending())
+    {
+        rx_done = false;
+        scheduler.release(TASK_CONTROL, now);
+    }
+
+    if (!scheduler.run(now))
+    {
+        scheduler.idle(control_pending);
     }
 }
@@ -0,0 +1,42 @@
+#pragma once
+
+// host stand-in for Adafruit NeoPixel: keeps the pixel colors and counts strip refreshes
+#include <Arduino.h>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel
+{
+public:
+    static constexpr uint16_t MAX_PIXELS = 16;
+
+    Adafruit_NeoPixel(uint16_t count, uint8_t pin, uint16_t type)
+        : _count(count)
+    {}
+
+    void begin() {}
+    bool canShow() const { return true; }
+    void show() { ++shows; }
+
+    void setPixelColor(uint16_t n, uint32_t color)
+    {
+        if (n < _count && n < MAX_PIXELS)
+        {
+            _colors[n] = color;
+        }
+    }
+
+    uint32_t getPixelColor(uint16_t n) const { return n < MAX_PIXELS ? _colors[n] : 0; }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b;
+    }
+
+    uint16_t shows = 0;
+
+private:
+    uint16_t _count;
+    uint32_t _colors[MAX_PIXELS] = {};
+};
@@ -0,0 +1,304 @@
+#pragma once
+
+// Host stand-in for the subset of the Arduino AVR core used by the firmware, for the native unit tests
+// (pio test -e native). Registers, pins and the clock are plain variables the tests set and inspect.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define bit(b) (1UL << (b))
+#define bitRead(value, b) (((value) >> (b)) & 0x01)
+#define _BV(b) (1 << (b))
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+static const uint8_t A0 = 14;
+static const uint8_t A1 = 15;
+static const uint8_t A2 = 16;
+static const uint8_t A3 = 17;
+static const uint8_t A4 = 18;
+static const uint8_t A5 = 19;
+static const uint8_t SDA = A4;
+static const uint8_t SCL = A5;
+static const uint8_t LED_BUILTIN = 13;
+
+namespace mock {
+
+constexpr uint8_t PIN_COUNT = 20;
+
+// one variable per register, identified by its name
+template <int ID>
+inline volatile uint8_t& reg8()
+{
+    static volatile uint8_t value = 0;
+    return value;
+}
+
+template <int ID>
+inline volatile uint16_t& reg16()
+{
+    static volatile uint16_t value = 0;
+    return value;
+}
+
+typedef void (*WriteHook)(uint8_t pin, uint8_t level);
+
+struct Pins
+{
+    uint8_t mode[PIN_COUNT];
+    uint8_t level[PIN_COUNT];
+    WriteHook on_write;  // called on every digitalWrite(), may be nullptr
+    uint32_t pulled_low;  // pins held low by another device: read low whatever their own level
+};
+
+inline Pins& pins()
+{
+    static Pins p = {};
+    return p;
+}
+
+// free running 16-bit timer count: every read advances it by one tick, so busy-waits on it terminate
+struct Counter16
+{
+    uint16_t value;
+
+    operator uint16_t() { return value++; }
+
+    Counter16& operator=(uint16_t v)
+    {
+        value = v;
+        return *this;
+    }
+};
+
+inline Counter16& timer1()
+{
+    static Counter16 counter = {0};
+    return counter;
+}
+
+// host clock behind micros() and millis() [us]
+inline uint32_t& clock_us()
+{
+    static uint32_t now = 0;
+    return now;
+}
+
+}  // namespace mock
+
+// status register (interrupts are never actually disabled on the host)
+#define SREG (mock::reg8<0>())
+
+// pin change interrupts
+#define PINB (mock::reg8<1>())
+#define PINC (mock::reg8<2>())
+#define PIND (mock::reg8<3>())
+#define PCIFR (mock::reg8<4>())
+#define PCICR (mock::reg8<5>())
+#define PCMSK0 (mock::reg8<6>())
+#define PCMSK1 (mock::reg8<7>())
+#define PCMSK2 (mock::reg8<8>())
+
+// Timer2 (Timer); interrupt flags are plain variables, not write-one-to-clear: tests clear them explicitly
+#define TCCR2A (mock::reg8<9>())
+#define TCCR2B (mock::reg8<10>())
+#define TIMSK2 (mock::reg8<11>())
+#define TCNT2 (mock::reg8<12>())
+#define TIFR2 (mock::reg8<13>())
+
+// Timer1 (RcPwm)
+#define TCCR1A (mock::reg8<14>())
+#define TCCR1B (mock::reg8<15>())
+#define TIFR1 (mock::reg8<16>())
+#define TIMSK1 (mock::reg8<17>())
+#define TCNT1 (mock::timer1())
+#define OCR1A (mock::reg16<1>())
+#define CS11 1
+#define OCF1A 1
+#define OCIE1A 1
+
+// reset cause and watchdog
+#define MCUSR (mock::reg8<18>())
+#define WDTCSR (mock::reg8<19>())
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void cli() {}
+inline void sei() {}
+
+inline unsigned long micros() { return mock::clock_us(); }
+inline unsigned long millis() { return mock::clock_us() / 1000; }
+inline void delay(unsigned long ms) { mock::clock_us() += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { mock::clock_us() += us; }
+
+constexpr long clockCyclesPerMicrosecond() { return 16; }
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+    mock::pins().mode[pin] = mode;
+    if (mode == INPUT_PULLUP)
+    {
+        mock::pins().level[pin] = HIGH;
+    }
+}
+
+namespace mock {
+
+// execution time of digitalWrite() on the target (about 3.5 us) in Timer1 ticks, so pin changes are timed as there;
+// port register writes take no time
+constexpr uint16_t DIGITAL_WRITE_TICKS = 7;
+
+}  // namespace mock
+
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+    mock::timer1().value += mock::DIGITAL_WRITE_TICKS;
+    mock::pins().level[pin] = level;
+    if (mock::pins().on_write)
+    {
+        mock::pins().on_write(pin, level);
+    }
+}
+
+inline int digitalRead(uint8_t pin) { return (mock::pins().pulled_low & bit(pin)) ? LOW : mock::pins().level[pin]; }
+
+// ATmega328 pin mapping: D0-D7 port D (PCINT2), D8-D13 port B (PCINT0), A0-A5 port C (PCINT1)
+inline uint8_t digitalPinToPCICRbit(uint8_t pin) { return pin <= 7 ? 2 : (pin <= 13 ? 0 : 1); }
+inline uint8_t digitalPinToPCMSKbit(uint8_t pin) { return pin <= 7 ? pin : (pin <= 13 ? pin - 8 : pin - 14); }
+inline uint8_t digitalPinToBitMask(uint8_t pin) { return static_cast<uint8_t>(bit(digitalPinToPCMSKbit(pin))); }
+inline uint8_t digitalPinToPort(uint8_t pin) { return digitalPinToPCICRbit(pin); }
+
+inline volatile uint8_t* digitalPinToPCMSK(uint8_t pin)
+{
+    switch (digitalPinToPCICRbit(pin))
+    {
+    case 0: return &PCMSK0;
+    case 1: return &PCMSK1;
+    default: return &PCMSK2;
+    }
+}
+
+inline volatile uint8_t* portInputRegister(uint8_t port)
+{
+    switch (port)
+    {
+    case 0: return &PINB;
+    case 1: return &PINC;
+    default: return &PIND;
+    }
+}
+
+namespace mock {
+
+// port output register: |= and &= set the levels of the port's pins, reported through the write hook per change
+struct OutputPort
+{
+    uint8_t port;
+
+    OutputPort& operator|=(uint8_t mask)
+    {
+        set(mask, HIGH);
+        return *this;
+    }
+
+    OutputPort& operator&=(uint8_t mask)
+    {
+        set(static_cast<uint8_t>(~mask), LOW);
+        return *this;
+    }
+
+    void set(uint8_t bits, uint8_t level)
+    {
+        for (uint8_t pin = 0; pin < PIN_COUNT; ++pin)
+        {
+            if (digitalPinToPort(pin) == port && (bits & digitalPinToBitMask(pin)) && pins().level[pin] != level)
+            {
+                pins().level[pin] = level;
+                if (pins().on_write)
+                {
+                    pins().on_write(pin, level);
+                }
+            }
+        }
+    }
+};
+
+inline OutputPort& output_port(uint8_t port)
+{
+    static OutputPort ports[3] = {{0}, {1}, {2}};
+    return ports[port];
+}
+
+}  // namespace mock
+
+inline mock::OutputPort* portOutputRegister(uint8_t port) { return &mock::output_port(port); }
+
+inline uint8_t pgm_read_byte(const void* p) { return *static_cast<const uint8_t*>(p); }
+inline uint16_t pgm_read_word(const void* p) { return *static_cast<const uint16_t*>(p); }
+inline uint32_t pgm_read_dword(const void* p) { return *static_cast<const uint32_t*>(p); }
+inline const void* pgm_read_ptr(const void* p) { return *static_cast<const void* const*>(p); }
+inline void* memcpy_P(void* dest, const void* src, size_t n) { return memcpy(dest, src, n); }
+
+// output is discarded
+class Print
+{
+public:
+    template <typename T>
+    size_t print(T) { return 0; }
+
+    template <typename T>
+    size_t print(T, int) { return 0; }
+
+    template <typename T>
+    size_t println(T) { return 0; }
+
+    size_t println() { return 0; }
+};
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    int availableForWrite() { return 63; }
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+namespace mock {
+
+inline HardwareSerial& serial()
+{
+    static HardwareSerial s;
+    return s;
+}
+
+}  // namespace mock
+
+#define Serial (mock::serial())
@@ -0,0 +1,31 @@
+#pragma once
+
+// host stand-in for the EEPROM library: 1 KiB of erased (0xff) memory
+#include <Arduino.h>
+
+class EEPROMClass
+{
+public:
+    EEPROMClass() { clear(); }
+
+    uint8_t read(int address) const { return _data[address]; }
+    void write(int address, uint8_t value) { _data[address] = value; }
+    void update(int address, uint8_t value) { _data[address] = value; }
+
+    void clear() { memset(_data, 0xff, sizeof(_data)); }
+
+private:
+    uint8_t _data[1024];
+};
+
+namespace mock {
+
+inline EEPROMClass& eeprom()
+{
+    static EEPROMClass e;
+    return e;
+}
+
+}  // namespace mock
+
+#define EEPROM (mock::eeprom())
@@ -0,0 +1,49 @@
+#pragma once
+
+// host stand-in for the i2cdevlib MPU6050 driver: all instances return the readings set in mock::imu()
+#include <Arduino.h>
+
+namespace mock {
+
+struct Imu
+{
+    int16_t ax, ay, az;
+    int16_t gx, gy, gz;
+    uint16_t reads;
+};
+
+inline Imu& imu()
+{
+    static Imu i = {};
+    return i;
+}
+
+}  // namespace mock
+
+class MPU6050
+{
+public:
+    void initialize() {}
+    bool testConnection() { return true; }
+    void setDLPFMode(uint8_t) {}
+    void setFullScaleGyroRange(uint8_t) {}
+    void setFullScaleAccelRange(uint8_t) {}
+
+    int16_t getRotationZ()
+    {
+        ++mock::imu().reads;
+        return mock::imu().gz;
+    }
+
+    void getMotion6(int16_t* ax, int16_t* ay, int16_t* az, int16_t* gx, int16_t* gy, int16_t* gz)
+    {
+        const mock::Imu& i = mock::imu();
+        ++mock::imu().reads;
+        *ax = i.ax;
+        *ay = i.ay;
+        *az = i.az;
+        *gx = i.gx;
+        *gy = i.gy;
+        *gz = i.gz;
+    }
+};
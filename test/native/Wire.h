@@ -0,0 +1,177 @@
+#pragma once
+
+// host stand-in for the Wire library: devices with 16-bit big endian registers (as the INA219), and switches that
+// make transactions time out like a hung bus or fail register writes
+#include <Arduino.h>
+
+class TwoWire
+{
+public:
+    static constexpr uint8_t MAX_DEVICES = 4;
+    static constexpr uint8_t MAX_REGISTERS = 8;
+
+    struct Device
+    {
+        uint8_t address;  // 0: unused
+        uint16_t reg[MAX_REGISTERS];
+        uint8_t pointer;
+        bool ina219;  // INA219 conversion ready flag: set by a configuration write, cleared by reading the power
+    };
+
+    // INA219 registers and flags of the ina219 model
+    static constexpr uint8_t INA219_CONFIG = 0x00;
+    static constexpr uint8_t INA219_BUS = 0x02;
+    static constexpr uint8_t INA219_POWER = 0x03;
+    static constexpr uint16_t INA219_CNVR = 0x0002;
+
+    void begin() { ++begins; }
+    void end() {}
+    void setClock(uint32_t hz) { clock = hz; }
+
+    void setWireTimeout(uint32_t timeout_us, bool reset_on_timeout)
+    {
+        timeout = timeout_us;
+        reset_with_timeout = reset_on_timeout;
+    }
+
+    bool getWireTimeoutFlag() const { return timeout_flag; }
+    void clearWireTimeoutFlag() { timeout_flag = false; }
+
+    void beginTransmission(uint8_t address)
+    {
+        _address = address;
+        _length = 0;
+    }
+
+    size_t write(uint8_t value)
+    {
+        if (_length < sizeof(_buffer))
+        {
+            _buffer[_length++] = value;
+        }
+        return 1;
+    }
+
+    uint8_t endTransmission(bool = true)
+    {
+        if (hung)
+        {
+            timeout_flag = true;
+            return 5;
+        }
+
+        Device* d = device(_address);
+        if (!d)
+            return 2;
+
+        if (_length >= 1)
+        {
+            d->pointer = _buffer[0] % MAX_REGISTERS;
+        }
+        if (_length >= 3)
+        {
+            if (failed_writes > 0)
+            {
+                // data not acknowledged: the register keeps its value
+                --failed_writes;
+                return 3;
+            }
+
+            d->reg[d->pointer] = (static_cast<uint16_t>(_buffer[1]) << 8) | _buffer[2];
+            ++writes;
+
+            // a configuration write starts a conversion; it completes before the driver waited its time out
+            if (d->ina219 && d->pointer == INA219_CONFIG)
+            {
+                d->reg[INA219_BUS] |= INA219_CNVR;
+            }
+        }
+        return 0;
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t count)
+    {
+        _read_length = 0;
+        _read_pos = 0;
+
+        if (hung)
+        {
+            timeout_flag = true;
+            return 0;
+        }
+
+        Device* d = device(address);
+        if (!d || count != 2)
+            return 0;
+
+        uint16_t value = d->reg[d->pointer];
+        _read[0] = static_cast<uint8_t>(value >> 8);
+        _read[1] = static_cast<uint8_t>(value);
+        _read_length = 2;
+
+        if (d->ina219 && d->pointer == INA219_POWER)
+        {
+            d->reg[INA219_BUS] &= ~INA219_CNVR;
+        }
+        return count;
+    }
+
+    int available() const { return _read_length - _read_pos; }
+    int read() { return _read_pos < _read_length ? _read[_read_pos++] : -1; }
+
+    // add a device, or return the one at \p address
+    Device& attach(uint8_t address)
+    {
+        Device* d = device(address);
+        for (uint8_t i = 0; !d && i < MAX_DEVICES; ++i)
+        {
+            if (devices[i].address == 0)
+            {
+                d = &devices[i];
+                *d = Device();
+                d->address = address;
+            }
+        }
+        return *d;
+    }
+
+    Device* device(uint8_t address)
+    {
+        for (uint8_t i = 0; i < MAX_DEVICES; ++i)
+        {
+            if (devices[i].address == address)
+                return &devices[i];
+        }
+        return nullptr;
+    }
+
+    Device devices[MAX_DEVICES] = {};
+    bool hung = false;  // every transaction times out
+    uint8_t failed_writes = 0;  // the next register writes are not acknowledged
+    bool timeout_flag = false;
+    bool reset_with_timeout = false;
+    uint32_t timeout = 0;
+    uint32_t clock = 100000;
+    uint16_t begins = 0;
+    uint16_t writes = 0;
+
+private:
+    uint8_t _address = 0;
+    uint8_t _buffer[8] = {};
+    uint8_t _length = 0;
+    uint8_t _read[2] = {};
+    uint8_t _read_length = 0;
+    uint8_t _read_pos = 0;
+};
+
+namespace mock {
+
+inline TwoWire& wire()
+{
+    static TwoWire w;
+    return w;
+}
+
+}  // namespace mock
+
+#define Wire (mock::wire())
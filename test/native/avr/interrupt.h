@@ -0,0 +1,7 @@
+#pragma once
+
+// host stand-in: interrupt vectors become plain functions the tests can call
+#include <Arduino.h>
+
+#define ISR(vector) extern "C" void vector()
+#define SIGNAL(vector) extern "C" void vector()
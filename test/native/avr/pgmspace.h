@@ -0,0 +1,4 @@
+#pragma once
+
+// host stand-in: program memory is ordinary memory (see Arduino.h)
+#include <Arduino.h>
@@ -0,0 +1,34 @@
+#pragma once
+
+// host stand-in: sleeping returns at once, is counted and calls mock::on_sleep() (e.g. to let time pass)
+#include <Arduino.h>
+
+#define SLEEP_MODE_IDLE 0
+
+namespace mock {
+
+inline uint32_t& sleeps()
+{
+    static uint32_t count = 0;
+    return count;
+}
+
+inline void (*&on_sleep())()
+{
+    static void (*hook)() = nullptr;
+    return hook;
+}
+
+}  // namespace mock
+
+inline void set_sleep_mode(uint8_t) {}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+inline void sleep_cpu()
+{
+    ++mock::sleeps();
+    if (mock::on_sleep())
+    {
+        mock::on_sleep()();
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// host stand-in: the watchdog is a counter of resets (see Arduino.h for WDTCSR and MCUSR)
+#include <Arduino.h>
+
+#define WDTO_15MS 0
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+
+namespace mock {
+
+inline uint32_t& wdt_resets()
+{
+    static uint32_t count = 0;
+    return count;
+}
+
+}  // namespace mock
+
+inline void wdt_reset() { ++mock::wdt_resets(); }
+inline void wdt_disable() { WDTCSR = 0; }
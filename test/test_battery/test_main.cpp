@@ -0,0 +1,183 @@
+#include "Battery.h"
+#include "voltage_data.h"
+#include <stdlib.h>
+#include <unity.h>
+
+// pack model: open-circuit voltage and internal resistance
+struct Pack
+{
+    int16_t ocv_mv;
+    int16_t resistance_mohm;
+
+    int16_t terminal(int16_t ma) const
+    {
+        return ocv_mv - static_cast<int16_t>((static_cast<int32_t>(ma) * resistance_mohm) / 1000);
+    }
+};
+
+// load steps between 1 A and 6 A, 40 frames each
+static int16_t load(uint16_t frame) { return (frame / 40) & 1 ? 6000 : 1000; }
+
+static void run(Battery& battery, const Pack& pack, uint16_t frames)
+{
+    for (uint16_t i = 0; i < frames; ++i)
+    {
+        int16_t ma = load(i);
+        battery.update(pack.terminal(ma), ma);
+    }
+}
+
+static Battery resting(int16_t mv)
+{
+    Battery battery;
+    battery.update(mv, 0);
+    battery.detectCells();
+    for (uint8_t i = 0; i < 100; ++i)
+    {
+        battery.update(mv, 0);
+    }
+    return battery;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_invalid_until_first_update()
+{
+    Battery battery;
+    TEST_ASSERT_FALSE(battery.valid());
+    battery.update(8000, 0);
+    TEST_ASSERT_TRUE(battery.valid());
+}
+
+void test_detect_cells()
+{
+    TEST_ASSERT_EQUAL_UINT8(1, resting(4100).cells());
+    TEST_ASSERT_EQUAL_UINT8(2, resting(7000).cells());
+    TEST_ASSERT_EQUAL_UINT8(2, resting(8400).cells());
+    TEST_ASSERT_EQUAL_UINT8(3, resting(11100).cells());
+    TEST_ASSERT_EQUAL_UINT8(3, resting(12600).cells());
+    TEST_ASSERT_EQUAL_UINT8(4, resting(13800).cells());
+    TEST_ASSERT_EQUAL_UINT8(4, resting(16800).cells());
+}
+
+void test_charge_curve()
+{
+    TEST_ASSERT_EQUAL_INT16(100, resting(8400).charge());
+    TEST_ASSERT_EQUAL_INT16(0, resting(6600).charge());
+    TEST_ASSERT_EQUAL_INT16(0, resting(6000).charge());
+    // 3.79 V per cell is 40%, 4.0 V 80%
+    TEST_ASSERT_INT16_WITHIN(1, 40, resting(7580).charge());
+    TEST_ASSERT_INT16_WITHIN(1, 80, resting(8000).charge());
+    // halfway between 3.82 and 3.87 V
+    TEST_ASSERT_INT16_WITHIN(1, 55, resting(3 * 3845).charge());
+}
+
+void test_estimates_internal_resistance()
+{
+    const Pack pack = {8000, 60};
+    Battery battery = resting(pack.ocv_mv);
+    run(battery, pack, 2000);
+
+    TEST_ASSERT_INT16_WITHIN(15, 60, battery.resistance());
+    TEST_ASSERT_INT16_WITHIN(60, 8000, battery.ocv());
+}
+
+void test_charge_ignores_sag_under_load()
+{
+    const Pack pack = {8000, 60};
+    Battery battery = resting(pack.ocv_mv);
+    int16_t rest_charge = battery.charge();
+    run(battery, pack, 2000);
+
+    // 6 A sags the terminal voltage by 360 mV, worth about 40% on the cell curve; the OCV estimate keeps the charge
+    TEST_ASSERT_INT16_WITHIN(8, rest_charge, battery.charge());
+}
+
+void test_terminal_voltage_follows_load()
+{
+    const Pack pack = {8000, 60};
+    Battery battery = resting(pack.ocv_mv);
+    run(battery, pack, 2000);
+
+    // end of a 6 A step
+    for (uint8_t i = 0; i < 40; ++i)
+    {
+        battery.update(pack.terminal(6000), 6000);
+    }
+    TEST_ASSERT_INT16_WITHIN(80, pack.terminal(6000), battery.terminalVoltage());
+}
+
+// recorded flight, see voltage_data.csv: one telemetry line per 13 RC frames of 20 ms, 52 battery updates of 5 ms
+static constexpr uint8_t UPDATES_PER_SAMPLE = 52;
+static constexpr uint16_t SAMPLES = sizeof(VOLTAGE_DATA) / sizeof(VOLTAGE_DATA[0]);
+
+// the log has no current: modeled from the fan commands with the sag the firmware used to compensate, 0.6 mV/us for
+// the thrust fans and 0.45 mV/us for the hover fan, at the 40 mOhm the estimator starts with
+static int16_t modelCurrent(const VoltageSample& sample)
+{
+    return abs(sample.tx_r - 1477) * 15 + abs(sample.tx_l - 1470) * 15 + (sample.tx_hm - 980) * 11;
+}
+
+void test_recorded_load_changes_keep_charge()
+{
+    static int16_t charge[SAMPLES];
+    Battery battery;
+    for (uint16_t i = 0; i < SAMPLES; ++i)
+    {
+        int16_t ma = modelCurrent(VOLTAGE_DATA[i]);
+        for (uint8_t k = 0; k < UPDATES_PER_SAMPLE; ++k)
+        {
+            battery.update(VOLTAGE_DATA[i].mv, ma);
+            if (i == 0 && k == 0)
+            {
+                battery.detectCells();
+            }
+        }
+        charge[i] = battery.charge();
+    }
+
+    // steering sags the pack by about 400 mV, worth 40% on the cell curve: the charge stays within 2% for a second
+    // after every step of more than 2 A
+    uint8_t steps = 0;
+    for (uint16_t i = 1; i + 4 < SAMPLES; ++i)
+    {
+        if (abs(modelCurrent(VOLTAGE_DATA[i]) - modelCurrent(VOLTAGE_DATA[i - 1])) > 2000)
+        {
+            ++steps;
+            for (uint8_t k = 0; k <= 4; ++k)
+            {
+                TEST_ASSERT_INT16_WITHIN(2, charge[i - 1], charge[i + k]);
+            }
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(20, steps);
+
+    // the log starts and ends at rest: the charge used in flight shows, at the value of the resting voltage
+    TEST_ASSERT_EQUAL_INT16(resting(VOLTAGE_DATA[0].mv).charge(), charge[0]);
+    TEST_ASSERT_INT16_WITHIN(2, resting(VOLTAGE_DATA[SAMPLES - 1].mv).charge(), charge[SAMPLES - 1]);
+}
+
+void test_throttle_limit()
+{
+    TEST_ASSERT_EQUAL_INT16(256, resting(8000).throttleLimit());
+    TEST_ASSERT_EQUAL_INT16(128, resting(6600).throttleLimit());
+
+    int16_t low = resting(2 * 3710).throttleLimit();  // 15%
+    TEST_ASSERT_GREATER_THAN(128, low);
+    TEST_ASSERT_LESS_THAN(256, low);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_invalid_until_first_update);
+    RUN_TEST(test_detect_cells);
+    RUN_TEST(test_charge_curve);
+    RUN_TEST(test_estimates_internal_resistance);
+    RUN_TEST(test_charge_ignores_sag_under_load);
+    RUN_TEST(test_terminal_voltage_follows_load);
+    RUN_TEST(test_recorded_load_changes_keep_charge);
+    RUN_TEST(test_throttle_limit);
+    return UNITY_END();
+}
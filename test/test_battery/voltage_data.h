@@ -0,0 +1,463 @@
+// generated by tools/voltage_data.py from test/test_battery/voltage_data.csv
+// fan commands tx_r, tx_l, tx_hm [us] and pack voltage [mV] per telemetry sample
+#pragma once
+
+#include <stdint.h>
+
+struct VoltageSample
+{
+    int16_t tx_r;
+    int16_t tx_l;
+    int16_t tx_hm;
+    int16_t mv;
+};
+
+static const VoltageSample VOLTAGE_DATA[] = {
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8080},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8080},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1470, 980, 8090},
+    {1477, 1470, 980, 8100},
+    {1477, 1471, 1131, 8070},
+    {1475, 1470, 1131, 8040},
+    {1475, 1470, 1131, 8010},
+    {1475, 1470, 1131, 8030},
+    {1474, 1471, 1131, 8030},
+    {1475, 1470, 1131, 8030},
+    {1475, 1470, 1131, 8030},
+    {1475, 1471, 1131, 8020},
+    {1477, 1470, 1131, 8020},
+    {1475, 1470, 1131, 8020},
+    {1474, 1471, 1131, 8010},
+    {1475, 1471, 1131, 8020},
+    {1476, 1471, 1131, 8020},
+    {1474, 1470, 1131, 8020},
+    {1475, 1471, 1131, 8020},
+    {1476, 1471, 1131, 8020},
+    {1476, 1470, 1131, 8020},
+    {1475, 1470, 1131, 8010},
+    {1475, 1471, 1131, 8020},
+    {1476, 1470, 1131, 8020},
+    {1474, 1470, 1131, 8020},
+    {1474, 1471, 1131, 8010},
+    {1476, 1470, 1131, 8020},
+    {1476, 1469, 1131, 8010},
+    {1477, 1472, 1131, 8010},
+    {1477, 1470, 1131, 8010},
+    {1477, 1472, 1131, 8020},
+    {1466, 1483, 1131, 7960},
+    {1412, 1529, 1131, 7990},
+    {1478, 1468, 1131, 8010},
+    {1482, 1471, 1131, 8010},
+    {1477, 1471, 1131, 8010},
+    {1474, 1473, 1131, 7900},
+    {1439, 1453, 1131, 8010},
+    {1476, 1467, 1131, 8010},
+    {1471, 1465, 1131, 7990},
+    {1469, 1466, 1131, 8000},
+    {1464, 1473, 1131, 7940},
+    {1403, 1542, 1131, 7800},
+    {1333, 1609, 1131, 7760},
+    {1289, 1650, 1131, 7740},
+    {1350, 1573, 1131, 7860},
+    {1268, 1668, 1131, 7650},
+    {1213, 1722, 1131, 7630},
+    {1218, 1717, 1131, 7640},
+    {1216, 1718, 1131, 7650},
+    {1219, 1719, 1131, 7910},
+    {1464, 1482, 1131, 7960},
+    {1455, 1479, 1131, 7950},
+    {1457, 1477, 1131, 7960},
+    {1510, 1408, 1131, 7720},
+    {1700, 1219, 1131, 7530},
+    {1719, 1217, 1131, 7610},
+    {1715, 1222, 1131, 7620},
+    {1714, 1223, 1131, 7650},
+    {1709, 1227, 1131, 7620},
+    {1635, 1373, 1131, 7930},
+    {1463, 1473, 1131, 7930},
+    {1477, 1460, 1131, 7920},
+    {1482, 1454, 1131, 7940},
+    {1482, 1455, 1131, 7930},
+    {1392, 1578, 1131, 7630},
+    {1222, 1717, 1131, 7550},
+    {1231, 1709, 1131, 7600},
+    {1247, 1694, 1131, 7620},
+    {1259, 1683, 1131, 7620},
+    {1212, 1731, 1131, 7580},
+    {1217, 1723, 1131, 7570},
+    {1222, 1720, 1131, 7580},
+    {1220, 1725, 1131, 7560},
+    {1221, 1722, 1131, 7560},
+    {1273, 1570, 1131, 7900},
+    {1496, 1445, 1131, 7890},
+    {1462, 1482, 1131, 7910},
+    {1466, 1477, 1131, 7900},
+    {1476, 1469, 1131, 7850},
+    {1706, 1236, 1131, 7580},
+    {1728, 1212, 1131, 7560},
+    {1720, 1222, 1131, 7580},
+    {1715, 1225, 1131, 7600},
+    {1712, 1232, 1131, 7570},
+    {1451, 1378, 1131, 7880},
+    {1462, 1478, 1131, 7900},
+    {1474, 1470, 1131, 7910},
+    {1476, 1467, 1131, 7900},
+    {1478, 1464, 1131, 7910},
+    {1481, 1464, 1131, 7910},
+    {1482, 1463, 1131, 7900},
+    {1478, 1462, 1131, 7910},
+    {1475, 1464, 1131, 7910},
+    {1474, 1466, 1131, 7920},
+    {1476, 1470, 1131, 7920},
+    {1476, 1470, 1131, 7920},
+    {1475, 1469, 1131, 7920},
+    {1475, 1470, 1131, 7920},
+    {1475, 1470, 1131, 7930},
+    {1475, 1470, 1131, 7920},
+    {1475, 1470, 1131, 7920},
+    {1474, 1470, 1131, 7940},
+    {1476, 1470, 1131, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7990},
+    {1477, 1470, 980, 7990},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8010},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8010},
+    {1477, 1470, 980, 8010},
+    {1477, 1470, 980, 8000},
+    {1477, 1470, 980, 8010},
+    {1477, 1470, 983, 8010},
+    {1477, 1470, 983, 8020},
+    {1477, 1470, 987, 8020},
+    {1477, 1470, 985, 8010},
+    {1477, 1470, 997, 8010},
+    {1477, 1470, 1014, 8000},
+    {1477, 1470, 1021, 7990},
+    {1477, 1470, 1030, 7990},
+    {1477, 1470, 1041, 7980},
+    {1477, 1470, 1057, 7980},
+    {1477, 1470, 1068, 7980},
+    {1477, 1470, 1088, 7980},
+    {1477, 1470, 1099, 7970},
+    {1477, 1470, 1095, 7980},
+    {1477, 1470, 1101, 7970},
+    {1477, 1470, 1102, 7960},
+    {1477, 1470, 1108, 7960},
+    {1477, 1470, 1114, 7960},
+    {1477, 1470, 1121, 7950},
+    {1477, 1470, 1136, 7950},
+    {1477, 1470, 1150, 7940},
+    {1477, 1470, 1158, 7940},
+    {1477, 1470, 1172, 7940},
+    {1477, 1470, 1169, 7940},
+    {1477, 1470, 1162, 7950},
+    {1477, 1470, 1153, 7950},
+    {1477, 1470, 1153, 7950},
+    {1477, 1470, 1144, 7950},
+    {1477, 1470, 1144, 7950},
+    {1477, 1470, 1148, 7940},
+    {1477, 1470, 1158, 7940},
+    {1477, 1470, 1147, 7940},
+    {1477, 1470, 1148, 7940},
+    {1477, 1470, 1148, 7940},
+    {1477, 1470, 1149, 7940},
+    {1477, 1470, 1149, 7940},
+    {1477, 1470, 1149, 7940},
+    {1477, 1470, 1147, 7940},
+    {1477, 1470, 1151, 7940},
+    {1477, 1470, 1150, 7950},
+    {1477, 1470, 1151, 7950},
+    {1477, 1470, 1152, 7950},
+    {1477, 1470, 1153, 7950},
+    {1477, 1470, 1153, 7940},
+    {1477, 1470, 1153, 7940},
+    {1477, 1470, 1153, 7930},
+    {1477, 1470, 1152, 7940},
+    {1477, 1470, 1153, 7950},
+    {1477, 1470, 1152, 7940},
+    {1477, 1470, 1153, 7940},
+    {1477, 1470, 1151, 7930},
+    {1477, 1470, 1154, 7930},
+    {1477, 1470, 1153, 7940},
+    {1477, 1470, 1154, 7940},
+    {1477, 1470, 1156, 7940},
+    {1477, 1470, 1150, 7940},
+    {1477, 1470, 1118, 7960},
+    {1477, 1470, 1111, 7960},
+    {1477, 1470, 1108, 7950},
+    {1477, 1470, 1126, 7950},
+    {1477, 1470, 1122, 7960},
+    {1477, 1470, 1124, 7950},
+    {1477, 1470, 1129, 7950},
+    {1477, 1470, 1128, 7950},
+    {1477, 1470, 1122, 7960},
+    {1477, 1470, 1127, 7960},
+    {1477, 1470, 1142, 7950},
+    {1477, 1470, 1134, 7960},
+    {1477, 1470, 1134, 7950},
+    {1477, 1470, 1134, 7960},
+    {1477, 1470, 1138, 7940},
+    {1477, 1470, 1136, 7950},
+    {1477, 1470, 1139, 7940},
+    {1477, 1470, 1148, 7950},
+    {1477, 1470, 1144, 7950},
+    {1477, 1470, 1146, 7960},
+    {1477, 1470, 1155, 7940},
+    {1477, 1470, 1149, 7940},
+    {1477, 1470, 1147, 7940},
+    {1477, 1470, 1143, 7940},
+    {1477, 1470, 1138, 7940},
+    {1477, 1470, 1139, 7940},
+    {1477, 1470, 1140, 7940},
+    {1477, 1470, 1147, 7930},
+    {1477, 1470, 1162, 7930},
+    {1477, 1470, 1175, 7920},
+    {1477, 1470, 1192, 7910},
+    {1477, 1470, 1225, 7900},
+    {1477, 1470, 1241, 7900},
+    {1477, 1470, 1249, 7880},
+    {1477, 1470, 1255, 7890},
+    {1477, 1470, 1258, 7880},
+    {1477, 1470, 1264, 7880},
+    {1477, 1470, 1270, 7870},
+    {1477, 1470, 1274, 7860},
+    {1477, 1470, 1279, 7860},
+    {1477, 1470, 1288, 7860},
+    {1477, 1470, 1301, 7840},
+    {1477, 1470, 1310, 7840},
+    {1477, 1470, 1330, 7840},
+    {1477, 1470, 1334, 7820},
+    {1477, 1470, 1340, 7820},
+    {1477, 1470, 1344, 7810},
+    {1477, 1470, 1351, 7830},
+    {1477, 1470, 1356, 7800},
+    {1477, 1470, 1368, 7810},
+    {1477, 1470, 1369, 7800},
+    {1477, 1470, 1375, 7800},
+    {1477, 1470, 1375, 7790},
+    {1477, 1470, 1382, 7800},
+    {1477, 1470, 1381, 7790},
+    {1477, 1470, 1345, 7810},
+    {1477, 1470, 1324, 7830},
+    {1477, 1470, 1307, 7830},
+    {1477, 1470, 1298, 7840},
+    {1477, 1470, 1291, 7850},
+    {1477, 1470, 1287, 7860},
+    {1477, 1470, 1292, 7840},
+    {1477, 1470, 1285, 7860},
+    {1477, 1470, 1274, 7850},
+    {1477, 1470, 1271, 7840},
+    {1477, 1470, 1272, 7840},
+    {1477, 1470, 1261, 7860},
+    {1477, 1470, 1266, 7850},
+    {1477, 1470, 1258, 7840},
+    {1477, 1470, 1258, 7850},
+    {1477, 1470, 1258, 7850},
+    {1477, 1470, 1257, 7840},
+    {1477, 1470, 1257, 7850},
+    {1477, 1470, 1260, 7840},
+    {1477, 1470, 1274, 7840},
+    {1477, 1470, 1264, 7860},
+    {1477, 1470, 1263, 7860},
+    {1477, 1470, 1246, 7860},
+    {1477, 1470, 1249, 7860},
+    {1477, 1470, 1241, 7860},
+    {1477, 1470, 1232, 7870},
+    {1477, 1470, 1225, 7860},
+    {1477, 1470, 1225, 7870},
+    {1477, 1470, 1223, 7860},
+    {1477, 1470, 1226, 7870},
+    {1477, 1470, 1218, 7870},
+    {1477, 1470, 1212, 7880},
+    {1477, 1470, 1206, 7880},
+    {1477, 1470, 1204, 7880},
+    {1477, 1470, 1203, 7880},
+    {1477, 1470, 1201, 7880},
+    {1477, 1470, 1199, 7890},
+    {1477, 1470, 1188, 7880},
+    {1477, 1470, 1193, 7880},
+    {1477, 1470, 1193, 7880},
+    {1477, 1470, 1196, 7880},
+    {1477, 1470, 1199, 7880},
+    {1477, 1470, 1206, 7870},
+    {1477, 1470, 1198, 7880},
+    {1477, 1470, 1198, 7890},
+    {1477, 1470, 1181, 7900},
+    {1477, 1470, 1167, 7890},
+    {1477, 1470, 1172, 7890},
+    {1477, 1470, 1176, 7900},
+    {1477, 1470, 1171, 7900},
+    {1477, 1470, 1172, 7900},
+    {1477, 1470, 1164, 7890},
+    {1477, 1470, 1163, 7900},
+    {1477, 1470, 1161, 7900},
+    {1477, 1470, 1161, 7900},
+    {1477, 1470, 1158, 7900},
+    {1477, 1470, 1154, 7920},
+    {1477, 1470, 1155, 7900},
+    {1477, 1470, 1152, 7900},
+    {1477, 1470, 1155, 7910},
+    {1477, 1470, 1152, 7900},
+    {1477, 1470, 1152, 7910},
+    {1477, 1470, 1148, 7910},
+    {1477, 1470, 1149, 7900},
+    {1477, 1470, 1153, 7900},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7980},
+    {1477, 1470, 980, 7990},
+    {1475, 1473, 1153, 7970},
+    {1477, 1471, 1153, 7910},
+    {1478, 1470, 1153, 7910},
+    {1476, 1470, 1153, 7910},
+    {1477, 1469, 1153, 7910},
+    {1478, 1470, 1153, 7920},
+    {1477, 1470, 1153, 7920},
+    {1476, 1470, 1153, 7910},
+    {1475, 1471, 1153, 7910},
+    {1473, 1471, 1153, 7920},
+    {1475, 1471, 1153, 7920},
+    {1472, 1474, 1153, 7920},
+    {1474, 1472, 1153, 7920},
+    {1475, 1472, 1153, 7900},
+    {1413, 1549, 1153, 7700},
+    {1327, 1618, 1153, 7650},
+    {1328, 1617, 1153, 7760},
+    {1375, 1569, 1153, 7810},
+    {1394, 1552, 1153, 7820},
+    {1417, 1527, 1153, 7900},
+    {1624, 1316, 1153, 7510},
+    {1644, 1306, 1153, 7720},
+    {1573, 1375, 1153, 7800},
+    {1583, 1361, 1153, 7770},
+    {1576, 1367, 1153, 7780},
+    {1572, 1373, 1153, 7780},
+    {1558, 1390, 1153, 7820},
+    {1540, 1407, 1153, 7860},
+    {1456, 1506, 1153, 7840},
+    {1466, 1478, 1153, 7850},
+    {1529, 1411, 1153, 7830},
+    {1519, 1416, 1153, 7800},
+    {1554, 1390, 1153, 7840},
+    {1524, 1442, 1153, 7900},
+    {1419, 1528, 1153, 7820},
+    {1436, 1509, 1153, 7870},
+    {1461, 1485, 1153, 7880},
+    {1475, 1471, 1153, 7850},
+    {1517, 1460, 1153, 7880},
+    {1481, 1466, 1153, 7880},
+    {1479, 1467, 1153, 7880},
+    {1476, 1475, 1153, 7870},
+    {1430, 1527, 1153, 7790},
+    {1413, 1531, 1153, 7850},
+    {1451, 1493, 1153, 7860},
+    {1571, 1542, 1153, 7740},
+    {1619, 1582, 1153, 7720},
+    {1679, 1680, 1153, 7560},
+    {1718, 1714, 1153, 7540},
+    {1718, 1715, 1153, 7550},
+    {1713, 1718, 1153, 7530},
+    {1720, 1712, 1153, 7520},
+    {1722, 1709, 1153, 7520},
+    {1718, 1713, 1153, 7510},
+    {1717, 1715, 1153, 7520},
+    {1715, 1716, 1153, 7520},
+    {1717, 1714, 1153, 7510},
+    {1719, 1714, 1153, 7510},
+    {1718, 1714, 1153, 7500},
+    {1717, 1715, 1153, 7520},
+    {1647, 1566, 1153, 7820},
+    {1472, 1474, 1153, 7820},
+    {1463, 1482, 1153, 7820},
+    {1466, 1475, 1153, 7750},
+    {1336, 1310, 1153, 7460},
+    {1254, 1242, 1153, 7530},
+    {1251, 1243, 1153, 7560},
+    {1249, 1245, 1153, 7560},
+    {1245, 1250, 1153, 7560},
+    {1249, 1248, 1153, 7560},
+    {1352, 1436, 1153, 7810},
+    {1471, 1473, 1153, 7820},
+    {1474, 1471, 1153, 7830},
+    {1472, 1473, 1153, 7830},
+    {1473, 1472, 1153, 7840},
+    {1476, 1470, 1153, 7840},
+    {1473, 1469, 1153, 7840},
+    {1474, 1471, 1153, 7840},
+    {1477, 1472, 1153, 7840},
+    {1474, 1470, 1153, 7850},
+    {1474, 1470, 1153, 7840},
+    {1474, 1471, 1153, 7850},
+    {1477, 1470, 980, 7920},
+    {1477, 1470, 980, 7920},
+    {1477, 1470, 980, 7920},
+    {1477, 1470, 980, 7920},
+    {1477, 1470, 980, 7930},
+    {1477, 1470, 980, 7920},
+    {1477, 1470, 980, 7930},
+    {1477, 1470, 980, 7930},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+    {1477, 1470, 980, 7940},
+};
@@ -0,0 +1,364 @@
+#include "Mixer.h"
+#include "RcChannel.h"
+#include "SeqLock.h"
+#include "ThrustCurve.h"
+#include "YawController.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+/*
+ * Host micro-benchmarks of the hot paths, built with -O2 in their own environment: pio test -e native_bench
+ *
+ * Each point runs a function over a table of pseudo-random but realistic inputs and keeps the fastest of several
+ * rounds. Host times say nothing about AVR cycles, so every point is reported relative to a calibration loop of
+ * 16-bit multiply-adds (one unit is roughly one such operation) and compared with the baseline below: a point fails
+ * when it got slower than its baseline by more than THRESHOLD. Points named "ref ..." time the code a change
+ * replaced, so the report shows the cost of the change; they are not gated.
+ *
+ * After an intended change in cost, update BASELINE from the "BENCH" lines of the test output.
+ */
+
+struct Baseline
+{
+    const char* name;
+    float units;  // cost per call [calibration units]
+};
+
+static const Baseline BASELINE[] = {
+    {"YawController::update", 10.5f},
+    {"RcChannel::rx pulse", 3.8f},
+    {"frame ISRs", 32.0f},
+    {"frame read", 17.6f},
+    {"ThrustCurve::toMicroseconds", 3.8f},
+    {"mixer and thrust curves", 11.1f},
+};
+
+static constexpr float THRESHOLD = 1.5f;
+
+static constexpr uint16_t INPUTS = 256;
+static constexpr uint8_t ROUNDS = 25;
+static constexpr uint16_t PASSES = 40;
+
+static volatile int32_t sink;
+
+// deterministic inputs (16-bit LCG), uniform in [lo, hi]
+class Random
+{
+public:
+    int16_t next(int16_t lo, int16_t hi)
+    {
+        _state = _state * 25173u + 13849u;
+        return static_cast<int16_t>(lo + static_cast<int32_t>(_state) * (hi - lo + 1) / 65536);
+    }
+
+private:
+    uint16_t _state = 1;
+};
+
+// time per call of \p fn(i) over all inputs [ns]
+template <typename F>
+static double time_per_call(F fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint16_t p = 0; p < PASSES; ++p)
+    {
+        for (uint16_t i = 0; i < INPUTS; ++i)
+        {
+            fn(i);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(PASSES) * INPUTS);
+}
+
+// one unit: a dependent 16-bit multiply-add
+static double unit_per_call()
+{
+    // a factor unknown at compile time, so the chain cannot be folded
+    static volatile int16_t seed = 3, factor = 7;
+    return time_per_call([](uint16_t i) {
+        int16_t acc = seed, f = factor;
+        for (uint8_t k = 0; k < 16; ++k)
+        {
+            acc = static_cast<int16_t>(acc * f + static_cast<int16_t>(i));
+        }
+        sink = acc;
+    }) / 16;
+}
+
+// report the cost of a point and check it against its baseline; returns the cost [calibration units]
+template <typename F>
+static double bench(const char* name, F fn)
+{
+    // fastest of several rounds, the calibration interleaved so that clock changes affect both alike
+    double best = 1e30, unit = 1e30;
+    for (uint8_t r = 0; r < ROUNDS; ++r)
+    {
+        unit = std::min(unit, unit_per_call());
+        best = std::min(best, time_per_call(fn));
+    }
+    double units = best / unit;
+
+    char line[96];
+    snprintf(line, sizeof(line), "BENCH %-32s %7.1f units %8.2f ns", name, units, best);
+    TEST_MESSAGE(line);
+
+    if (strncmp(name, "ref ", 4) == 0)
+        return units;
+
+    for (const Baseline& b : BASELINE)
+    {
+        if (strcmp(b.name, name) == 0)
+        {
+            snprintf(line, sizeof(line), "%s: %.1f units, baseline %.1f", name, units, b.units);
+            TEST_ASSERT_TRUE_MESSAGE(units <= b.units * THRESHOLD, line);
+            return units;
+        }
+    }
+    TEST_FAIL_MESSAGE("no baseline");
+    return units;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// YawController against the proportional gyro term it replaced in handle_hover_state()
+void test_yaw_controller()
+{
+    static int16_t steering[INPUTS], rate[INPUTS], damping[INPUTS];
+    Random random;
+    for (uint16_t i = 0; i < INPUTS; ++i)
+    {
+        steering[i] = random.next(-400, 400);
+        rate[i] = random.next(-2000, 2000);
+        damping[i] = random.next(0, 32);
+    }
+
+    static YawController controller({32, 2, 8, 64}, 400);
+    bench("YawController::update", [](uint16_t i) {
+        int16_t setpoint = (static_cast<int32_t>(steering[i]) * 96) / 64;
+        sink = controller.update(steering[i], setpoint, rate[i], damping[i]);
+    });
+
+    bench("ref P term", [](uint16_t i) {
+        int16_t dir_gyro = (rate[i] * ((damping[i] / 2) + 16)) / 64;
+        sink = steering[i] + dir_gyro;
+    });
+}
+
+// RcChannel::rx() before the median filter: edge detection from PIND, volatile state
+class RcChannelBefore
+{
+public:
+    bool rx(uint8_t pind, uint32_t us)
+    {
+        bool falling = false;
+        if ((pind ^ _prev_pind) & _mask)
+        {
+            if ((pind & _mask) != 0)
+            {
+                if (_prev_start == 0 || us - _prev_start >= RcChannel::MIN_PERIOD)
+                {
+                    _start = us;
+                    _prev_start = us;
+                }
+                else if (_glitches < 255)
+                {
+                    ++_glitches;
+                }
+            }
+            else if (_start != 0)
+            {
+                uint32_t length = us - _start;
+                _start = 0;
+                falling = true;
+                if (length >= RcChannel::MIN_PULSE && length <= RcChannel::MAX_PULSE)
+                {
+                    _pulse_length = length;
+                    _last_valid = us;
+                }
+                else if (_glitches < 255)
+                {
+                    ++_glitches;
+                }
+            }
+            _prev_pind = pind;
+        }
+        return falling;
+    }
+
+    volatile uint32_t _pulse_length = 0;
+
+private:
+    const uint8_t _mask = 0x10;
+    volatile uint32_t _start = 0;
+    volatile uint8_t _prev_pind = 0;
+    volatile uint32_t _prev_start = 0;
+    volatile uint32_t _last_valid = 0;
+    volatile uint8_t _glitches = 0;
+};
+
+static constexpr uint8_t RX_CHANNELS = 3;
+
+// as in main.cpp
+struct RxFrame
+{
+    uint16_t pulse[RX_CHANNELS];
+    uint8_t fresh;
+};
+
+// median filter and sequence lock against the ISR stored pulse read under an interrupt lock
+void test_rc_input()
+{
+    static uint16_t pulse[INPUTS];
+    static uint16_t period[INPUTS];
+    Random random;
+    for (uint16_t i = 0; i < INPUTS; ++i)
+    {
+        pulse[i] = random.next(1000 * COUNT_PER_MICROS, 2000 * COUNT_PER_MICROS);
+        period[i] = random.next(19000 * COUNT_PER_MICROS, 21000 * COUNT_PER_MICROS);
+    }
+
+    // pin change ISR: a rising and a falling edge
+    static RcChannel channel(2, 1500 * COUNT_PER_MICROS);
+    static uint32_t now = 0;
+    bench("RcChannel::rx pulse", [](uint16_t i) {
+        now += period[i];
+        channel.rx(true, now);
+        sink = channel.rx(false, now + pulse[i]);
+    });
+
+    static RcChannelBefore before;
+    bench("ref RcChannel::rx pulse", [](uint16_t i) {
+        now += period[i];
+        before.rx(0x10, now);
+        sink = before.rx(0x00, now + pulse[i]);
+    });
+
+    // all ISR work of a frame: the pulses of three channels, then the hover channel publishes the frame
+    static RcChannel channels[RX_CHANNELS] = {{2, 0}, {3, 0}, {4, 0}};
+    static SeqLock<RxFrame> frames;
+    bench("frame ISRs", [](uint16_t i) {
+        now += period[i];
+        for (uint8_t c = 0; c < RX_CHANNELS; ++c)
+        {
+            channels[c].rx(true, now);
+            channels[c].rx(false, now + pulse[(i + c) % INPUTS]);
+        }
+
+        RxFrame frame;
+        frame.fresh = 0;
+        for (uint8_t c = 0; c < RX_CHANNELS; ++c)
+        {
+            if (channels[c].take(frame.pulse[c]))
+            {
+                frame.fresh |= bit(c);
+            }
+        }
+        frames.write(frame);
+    });
+
+    static RcChannelBefore befores[RX_CHANNELS];
+    bench("ref frame ISRs", [](uint16_t i) {
+        now += period[i];
+        for (uint8_t c = 0; c < RX_CHANNELS; ++c)
+        {
+            befores[c].rx(0x10, now);
+            befores[c].rx(0x00, now + pulse[(i + c) % INPUTS]);
+        }
+    });
+
+    // control frame: snapshot, filter update, start expiry and median
+    bench("frame read", [](uint16_t i) {
+        RxFrame frame;
+        sink = frames.read(frame);
+        for (uint8_t c = 0; c < RX_CHANNELS; ++c)
+        {
+            channels[c].update(frame.pulse[c], (frame.fresh & bit(c)) != 0, now);
+            channels[c].expire(now);
+            sink = channels[c].pulse_length();
+        }
+    });
+
+    bench("ref frame read", [](uint16_t) {
+        uint8_t SREG_old = SREG;
+        noInterrupts();
+        for (uint8_t c = 0; c < RX_CHANNELS; ++c)
+        {
+            sink = befores[c]._pulse_length;
+        }
+        SREG = SREG_old;
+    });
+}
+
+// the mixer rows of main.cpp
+enum MixerOutput : uint8_t
+{
+    MIX_RIGHT_FAN,
+    MIX_LEFT_FAN,
+    MIX_HOVER_FAN,
+    MIX_COUNT
+};
+
+constexpr MixerRow MIXER_ROWS[MIX_COUNT] = {
+    {64, -64, 0, 1477, 1020, 1980},
+    {64, 64, 0, 1470, 1020, 1980},
+    {0, 0, 64, 980, 980, 2020},
+};
+typedef Mixer<MIX_COUNT, MIXER_ROWS> HoverMixer;
+
+// compile-time mixer against the hand-written mixing it replaced in handle_hover_state()
+void test_mixer()
+{
+    static int16_t thrust[INPUTS], yaw[INPUTS], hover[INPUTS];
+    Random random;
+    for (uint16_t i = 0; i < INPUTS; ++i)
+    {
+        thrust[i] = random.next(-500, 500);
+        yaw[i] = random.next(-400, 400);
+        hover[i] = random.next(0, 1000);
+    }
+
+    static ThrustCurve right_curve, left_curve;
+    right_curve.select(ThrustCurve::forCells(3));
+    left_curve.select(ThrustCurve::forCells(3));
+
+    bench("ThrustCurve::toMicroseconds", [](uint16_t i) { sink = right_curve.toMicroseconds(thrust[i]); });
+
+    double mixer = bench("mixer and thrust curves", [](uint16_t i) {
+        const MixerInput input = {thrust[i], yaw[i], hover[i]};
+        sink = HoverMixer::output<MIX_HOVER_FAN>(HoverMixer::mix<MIX_HOVER_FAN>(input));
+        int16_t right_offset = right_curve.toMicroseconds(HoverMixer::mix<MIX_RIGHT_FAN>(input));
+        int16_t left_offset = left_curve.toMicroseconds(HoverMixer::mix<MIX_LEFT_FAN>(input));
+        sink = HoverMixer::output<MIX_RIGHT_FAN>(right_offset);
+        sink = HoverMixer::output<MIX_LEFT_FAN>(left_offset);
+    });
+
+    // the clamps of the old code were in Motor::set()
+    double hand_written = bench("ref hand-written mixing", [](uint16_t i) {
+        sink = estd::clamp(static_cast<int16_t>(980 + hover[i]), static_cast<int16_t>(980), static_cast<int16_t>(2020));
+        int16_t right_us = thrust[i] - yaw[i];
+        int16_t left_us = thrust[i] + yaw[i];
+        int16_t right_offset = right_curve.toMicroseconds(right_us);
+        int16_t left_offset = left_curve.toMicroseconds(left_us);
+        sink = estd::clamp(static_cast<int16_t>(right_offset + 1477), static_cast<int16_t>(1020),
+            static_cast<int16_t>(1980));
+        sink = estd::clamp(static_cast<int16_t>(left_offset + 1470), static_cast<int16_t>(1020),
+            static_cast<int16_t>(1980));
+    });
+
+    // no regression against the hand-written mixing, within the measurement noise
+    TEST_ASSERT_TRUE(mixer <= hand_written * 1.2);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_yaw_controller);
+    RUN_TEST(test_rc_input);
+    RUN_TEST(test_mixer);
+    return UNITY_END();
+}
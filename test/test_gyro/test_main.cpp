@@ -0,0 +1,205 @@
+#include "Gyro.h"
+#include <unity.h>
+
+static int16_t lsb(float dps) { return static_cast<int16_t>(dps * Gyro::LSB_PER_DPS); }
+
+// read \p frames samples of \p raw, with +/- \p noise LSB alternating
+static void feed(Gyro& gyro, int16_t raw, uint16_t frames, int16_t noise = 0)
+{
+    for (uint16_t i = 0; i < frames; ++i)
+    {
+        mock::imu().gz = raw + ((i & 1) ? noise : -noise);
+        gyro.read();
+    }
+}
+
+// calibrate until done or \p frames ran out, returns the number of frames needed (0: never)
+static uint16_t calibrate(Gyro& gyro, int16_t raw, uint16_t frames)
+{
+    gyro.startCalibration();
+    for (uint16_t i = 1; i <= frames; ++i)
+    {
+        mock::imu().gz = raw + ((i & 1) ? 3 : -3);
+        gyro.read();
+        if (gyro.calibrate())
+            return i;
+    }
+    return 0;
+}
+
+void setUp()
+{
+    EEPROM.clear();
+    mock::imu() = mock::Imu();
+}
+
+void tearDown() {}
+
+void test_first_boot_calibrates_with_large_offset()
+{
+    // erased EEPROM, no bias estimate; the sensor offset is 20 degrees/s
+    Gyro gyro;
+    gyro.setup();
+    TEST_ASSERT_FALSE(gyro.seeded());
+
+    const int16_t offset = lsb(20);
+    TEST_ASSERT_NOT_EQUAL(0, calibrate(gyro, offset, 200));
+    TEST_ASSERT_TRUE(gyro.seeded());
+    TEST_ASSERT_INT16_WITHIN(4, offset, gyro.baseline());
+
+    // stored for the next boot
+    Gyro next;
+    next.setup();
+    TEST_ASSERT_TRUE(next.seeded());
+    TEST_ASSERT_INT16_WITHIN(4, offset, next.baseline());
+}
+
+void test_negative_offset()
+{
+    Gyro gyro;
+    gyro.setup();
+    TEST_ASSERT_NOT_EQUAL(0, calibrate(gyro, lsb(-18), 200));
+    TEST_ASSERT_INT16_WITHIN(4, lsb(-18), gyro.baseline());
+}
+
+void test_idle_seeds_bias()
+{
+    Gyro gyro;
+    gyro.setup();
+    for (uint8_t i = 0; i < 20; ++i)
+    {
+        feed(gyro, lsb(15), 1, 2);
+        gyro.updateBias(Gyro::BIAS_SHIFT_IDLE);
+    }
+    TEST_ASSERT_TRUE(gyro.seeded());
+    TEST_ASSERT_INT16_WITHIN(3, lsb(15), gyro.baseline());
+    TEST_ASSERT_TRUE(gyro.still());
+    TEST_ASSERT_INT16_WITHIN(3, 0, gyro.rate());
+}
+
+void test_hover_does_not_seed()
+{
+    // a slow steady turn looks still; hover must not take it for the bias
+    Gyro gyro;
+    gyro.setup();
+    for (uint8_t i = 0; i < 50; ++i)
+    {
+        feed(gyro, lsb(15), 1);
+        gyro.updateBias(Gyro::BIAS_SHIFT_HOVER);
+    }
+    TEST_ASSERT_FALSE(gyro.seeded());
+    TEST_ASSERT_EQUAL_INT16(0, gyro.baseline());
+}
+
+void test_motion_is_not_still()
+{
+    Gyro gyro;
+    gyro.setup();
+    // vibration: large sample-to-sample changes
+    feed(gyro, 0, 50, lsb(5));
+    TEST_ASSERT_FALSE(gyro.still());
+    TEST_ASSERT_EQUAL(0, calibrate(gyro, 0, 0));
+}
+
+void test_turn_is_not_still_once_seeded()
+{
+    Gyro gyro;
+    gyro.setup();
+    TEST_ASSERT_NOT_EQUAL(0, calibrate(gyro, lsb(10), 200));
+
+    // a steady 5 degrees/s turn on top of the bias fails the rate test
+    feed(gyro, lsb(10) + lsb(5), 50);
+    TEST_ASSERT_FALSE(gyro.still());
+    int16_t baseline = gyro.baseline();
+    gyro.updateBias(Gyro::BIAS_SHIFT_IDLE);
+    TEST_ASSERT_EQUAL_INT16(baseline, gyro.baseline());
+
+    // back at rest
+    feed(gyro, lsb(10), 50);
+    TEST_ASSERT_TRUE(gyro.still());
+}
+
+void test_bias_tracks_drift()
+{
+    Gyro gyro;
+    gyro.setup();
+    TEST_ASSERT_NOT_EQUAL(0, calibrate(gyro, 100, 200));
+
+    // bias drifts by 1 degree/s, within the still rate window
+    for (uint16_t i = 0; i < 1000; ++i)
+    {
+        feed(gyro, 100 + lsb(1), 1);
+        gyro.updateBias(Gyro::BIAS_SHIFT_IDLE);
+    }
+    // settles within the Q4 resolution of the filter step, 2^(shift - 4) LSB
+    TEST_ASSERT_INT16_WITHIN(1 << (Gyro::BIAS_SHIFT_IDLE - 4), 100 + lsb(1), gyro.baseline());
+}
+
+void test_read_scales_rate()
+{
+    Gyro gyro;
+    gyro.setup();
+    TEST_ASSERT_NOT_EQUAL(0, calibrate(gyro, 200, 200));
+    mock::imu().gz = 200 + 1600;
+    TEST_ASSERT_INT16_WITHIN(1, 100, gyro.read());
+    TEST_ASSERT_INT16_WITHIN(8, 1600, gyro.rate());
+}
+
+void test_hold_restores_last_good_sample()
+{
+    Gyro gyro;
+    gyro.setup();
+    gyro.enableMotion();
+    TEST_ASSERT_NOT_EQUAL(0, calibrate(gyro, 200, 200));
+    TEST_ASSERT_TRUE(gyro.still());
+
+    mock::imu().gz = 200 + 64;
+    mock::imu().ax = 1000;
+    mock::imu().ay = -500;
+    int16_t good = gyro.read();
+    int16_t good_rate = gyro.rate();
+
+    // a timed out transaction leaves garbage
+    mock::imu().gz = -30000;
+    mock::imu().ax = 12345;
+    mock::imu().ay = 12345;
+    gyro.read();
+
+    TEST_ASSERT_EQUAL_INT16(good, gyro.hold());
+    TEST_ASSERT_EQUAL_INT16(good_rate, gyro.rate());
+    TEST_ASSERT_EQUAL_INT16(1000, gyro.accelX());
+    TEST_ASSERT_EQUAL_INT16(-500, gyro.accelY());
+    TEST_ASSERT_FALSE(gyro.still());
+
+    // the next good sample continues from the restored one: no activity spike from the garbage
+    mock::imu().gz = 200 + 64;
+    TEST_ASSERT_EQUAL_INT16(good, gyro.read());
+    feed(gyro, 200 + 64, 16, 3);
+    TEST_ASSERT_TRUE(gyro.still());
+}
+
+void test_z_units()
+{
+    // read() returns rate / 16: 20 degrees/s are 1310 LSB or 82 gyro units
+    TEST_ASSERT_EQUAL_INT16(82, Gyro::zUnits(20));
+    TEST_ASSERT_EQUAL_INT16(-82, Gyro::zUnits(-20));
+    TEST_ASSERT_EQUAL_INT16(4, Gyro::zUnits(1));
+    TEST_ASSERT_EQUAL_INT16(0, Gyro::zUnits(0));
+    TEST_ASSERT_INT16_WITHIN(1, lsb(20) / 16, Gyro::zUnits(20));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_boot_calibrates_with_large_offset);
+    RUN_TEST(test_negative_offset);
+    RUN_TEST(test_idle_seeds_bias);
+    RUN_TEST(test_hover_does_not_seed);
+    RUN_TEST(test_motion_is_not_still);
+    RUN_TEST(test_turn_is_not_still_once_seeded);
+    RUN_TEST(test_bias_tracks_drift);
+    RUN_TEST(test_read_scales_rate);
+    RUN_TEST(test_hold_restores_last_good_sample);
+    RUN_TEST(test_z_units);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#include "Heading.h"
+#include <unity.h>
+
+// Timer counts per 10 ms frame
+static constexpr uint32_t FRAME_COUNT = 10000UL * COUNT_PER_MICROS;
+
+static int16_t lsb(float dps) { return static_cast<int16_t>(dps * Gyro::LSB_PER_DPS); }
+
+// integrate \p rate for \p frames frames of 10 ms starting at \p now, returns the end count
+static uint32_t spin(Heading& heading, int16_t rate, uint16_t frames, uint32_t now)
+{
+    for (uint16_t i = 0; i < frames; ++i)
+    {
+        now += FRAME_COUNT;
+        heading.integrate(rate, now);
+    }
+    return now;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_still_keeps_heading()
+{
+    Heading heading;
+    heading.restart(0);
+    spin(heading, 0, 500, 0);
+    TEST_ASSERT_EQUAL_UINT16(0, heading.value());
+}
+
+void test_constant_rate_integrates_to_angle()
+{
+    Heading heading;
+    heading.restart(0);
+    // 90 degrees/s for one second
+    spin(heading, lsb(90), 100, 0);
+    TEST_ASSERT_UINT16_WITHIN(100, 16384, heading.value());
+    TEST_ASSERT_INT16_WITHIN(1, 90, heading.degrees());
+}
+
+void test_negative_rate_and_wrap()
+{
+    Heading heading;
+    heading.restart(0);
+    // -45 degrees/s for one second wraps below zero
+    spin(heading, lsb(-45), 100, 0);
+    TEST_ASSERT_UINT16_WITHIN(100, 65536 - 8192, heading.value());
+    TEST_ASSERT_INT16_WITHIN(1, -45, heading.degrees());
+
+    // heading differences wrap correctly as int16_t
+    int16_t error = static_cast<int16_t>(8192 - heading.value());
+    TEST_ASSERT_INT16_WITHIN(100, 16384, error);
+}
+
+void test_small_rates_are_not_lost()
+{
+    // 1 degree/s is less than one binary angle unit per frame; the remainder carries over
+    Heading heading;
+    heading.restart(0);
+    spin(heading, lsb(1), 1000, 0);
+    TEST_ASSERT_INT16_WITHIN(1, 10, heading.degrees());
+}
+
+void test_uses_sample_time_not_nominal_period()
+{
+    // the same angle in 50 frames of 20 ms as in 100 frames of 10 ms
+    Heading heading;
+    heading.restart(0);
+    uint32_t now = 0;
+    for (uint8_t i = 0; i < 50; ++i)
+    {
+        now += 2 * FRAME_COUNT;
+        heading.integrate(lsb(90), now);
+    }
+    TEST_ASSERT_UINT16_WITHIN(100, 16384, heading.value());
+}
+
+void test_long_gap_is_limited()
+{
+    Heading heading;
+    heading.restart(0);
+    // a 10 s gap counts as MAX_DT_COUNT only
+    heading.integrate(lsb(90), 10000000UL * COUNT_PER_MICROS);
+    float max_degrees = 90.0f * Heading::MAX_DT_COUNT / COUNT_PER_MICROS / 1e6f;
+    TEST_ASSERT_INT16_WITHIN(1, static_cast<int16_t>(max_degrees), heading.degrees());
+}
+
+void test_restart_keeps_heading()
+{
+    Heading heading;
+    heading.restart(0);
+    uint32_t now = spin(heading, lsb(90), 50, 0);
+    uint16_t before = heading.value();
+
+    // restarting after a pause does not integrate the pause
+    heading.restart(now + 5000000UL);
+    heading.integrate(lsb(90), now + 5000000UL);
+    TEST_ASSERT_EQUAL_UINT16(before, heading.value());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_still_keeps_heading);
+    RUN_TEST(test_constant_rate_integrates_to_angle);
+    RUN_TEST(test_negative_rate_and_wrap);
+    RUN_TEST(test_small_rates_are_not_lost);
+    RUN_TEST(test_uses_sample_time_not_nominal_period);
+    RUN_TEST(test_long_gap_is_limited);
+    RUN_TEST(test_restart_keeps_heading);
+    return UNITY_END();
+}
@@ -0,0 +1,66 @@
+#include "Battery.h"
+#include <unity.h>
+
+static constexpr int16_t ZERO = 980;
+static constexpr int16_t TUNED = 1300;
+
+static Battery at(int16_t mv)
+{
+    Battery battery;
+    for (uint8_t i = 0; i < 200; ++i)
+    {
+        battery.update(mv, 0);
+    }
+    return battery;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_unknown_reference_keeps_command()
+{
+    TEST_ASSERT_EQUAL_INT16(TUNED, at(7000).compensate(TUNED, ZERO, 0));
+    TEST_ASSERT_EQUAL_INT16(TUNED, Battery().compensate(TUNED, ZERO, 8000));
+}
+
+void test_reference_voltage_keeps_command()
+{
+    TEST_ASSERT_INT16_WITHIN(1, TUNED, at(8000).compensate(TUNED, ZERO, 8000));
+}
+
+void test_discharge_keeps_power()
+{
+    // tuned on a full 2S pack, simulated discharge down to 3.3 V per cell
+    for (int16_t mv = 8400; mv >= 6600; mv -= 200)
+    {
+        int16_t command = at(mv).compensate(TUNED, ZERO, 8400);
+        int32_t power = static_cast<int32_t>(command - ZERO) * mv;
+        int32_t tuned_power = static_cast<int32_t>(TUNED - ZERO) * 8400;
+        TEST_ASSERT_INT32_WITHIN(tuned_power / 100, tuned_power, power);
+        TEST_ASSERT_GREATER_OR_EQUAL(TUNED, command);
+    }
+}
+
+void test_scale_is_limited()
+{
+    // half the tuning voltage would double the command; limited to 1.5
+    TEST_ASSERT_EQUAL_INT16(ZERO + (TUNED - ZERO) * 3 / 2, at(4000).compensate(TUNED, ZERO, 8000));
+    // a much higher voltage is limited to 0.75
+    TEST_ASSERT_EQUAL_INT16(ZERO + (TUNED - ZERO) * 3 / 4, at(16000).compensate(TUNED, ZERO, 8000));
+}
+
+void test_zero_command_stays_zero()
+{
+    TEST_ASSERT_EQUAL_INT16(ZERO, at(7000).compensate(ZERO, ZERO, 8400));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_unknown_reference_keeps_command);
+    RUN_TEST(test_reference_voltage_keeps_command);
+    RUN_TEST(test_discharge_keeps_power);
+    RUN_TEST(test_scale_is_limited);
+    RUN_TEST(test_zero_command_stays_zero);
+    return UNITY_END();
+}
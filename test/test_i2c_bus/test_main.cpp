@@ -0,0 +1,138 @@
+#include "I2cBus.h"
+#include <unity.h>
+
+// SCL clocks seen during recovery, and after how many the slave releases SDA
+static uint8_t clocks;
+static uint8_t release_after;
+static uint8_t sda_lows;
+
+static void record(uint8_t pin, uint8_t level)
+{
+    if (level != LOW)
+        return;
+
+    if (pin == SCL && ++clocks >= release_after)
+    {
+        mock::pins().pulled_low &= ~bit(SDA);
+    }
+    else if (pin == SDA)
+    {
+        ++sda_lows;
+    }
+}
+
+// a transaction on the hung bus; it times out
+static void timeout()
+{
+    Wire.hung = true;
+    Wire.beginTransmission(0x68);
+    Wire.write(0x3b);
+    TEST_ASSERT_EQUAL_UINT8(5, Wire.endTransmission());
+    Wire.hung = false;
+}
+
+void setUp()
+{
+    Wire = TwoWire();
+    mock::pins() = mock::Pins();
+    mock::pins().on_write = record;
+    clocks = 0;
+    sda_lows = 0;
+    release_after = 0;
+}
+
+void tearDown() {}
+
+void test_setup_sets_clock_and_timeout()
+{
+    I2cBus bus;
+    bus.setup();
+    TEST_ASSERT_EQUAL_UINT32(I2cBus::CLOCK_HZ, Wire.clock);
+    TEST_ASSERT_EQUAL_UINT32(I2cBus::TIMEOUT_US, Wire.timeout);
+    TEST_ASSERT_TRUE(Wire.reset_with_timeout);
+}
+
+void test_check_without_timeout_does_nothing()
+{
+    I2cBus bus;
+    bus.setup();
+    TEST_ASSERT_FALSE(bus.check());
+    TEST_ASSERT_EQUAL_UINT16(0, bus.timeouts());
+    TEST_ASSERT_EQUAL_UINT16(0, Wire.begins);
+    TEST_ASSERT_EQUAL_UINT8(0, clocks);
+}
+
+void test_timeout_is_reported_once_and_recovered()
+{
+    I2cBus bus;
+    bus.setup();
+    timeout();
+
+    TEST_ASSERT_TRUE(bus.check());
+    TEST_ASSERT_EQUAL_UINT16(1, bus.timeouts());
+    TEST_ASSERT_FALSE(Wire.getWireTimeoutFlag());
+
+    // TWI restarted with the same configuration
+    TEST_ASSERT_EQUAL_UINT16(1, Wire.begins);
+    TEST_ASSERT_EQUAL_UINT32(I2cBus::CLOCK_HZ, Wire.clock);
+    TEST_ASSERT_EQUAL_UINT32(I2cBus::TIMEOUT_US, Wire.timeout);
+
+    // free bus: no clocks, only the STOP
+    TEST_ASSERT_EQUAL_UINT8(0, clocks);
+    TEST_ASSERT_EQUAL_UINT8(1, sda_lows);
+    TEST_ASSERT_EQUAL_UINT8(INPUT_PULLUP, mock::pins().mode[SDA]);
+    TEST_ASSERT_EQUAL_UINT8(INPUT_PULLUP, mock::pins().mode[SCL]);
+
+    TEST_ASSERT_FALSE(bus.check());
+    TEST_ASSERT_EQUAL_UINT16(1, bus.timeouts());
+}
+
+void test_recovery_clocks_until_sda_released()
+{
+    I2cBus bus;
+    bus.setup();
+    timeout();
+
+    // the slave finishes its byte after 3 clocks
+    mock::pins().pulled_low = bit(SDA);
+    release_after = 3;
+    TEST_ASSERT_TRUE(bus.check());
+    TEST_ASSERT_EQUAL_UINT8(3, clocks);
+    TEST_ASSERT_EQUAL_UINT8(1, sda_lows);
+}
+
+void test_recovery_gives_up_after_nine_clocks()
+{
+    I2cBus bus;
+    bus.setup();
+    timeout();
+
+    mock::pins().pulled_low = bit(SDA);
+    release_after = 255;
+    TEST_ASSERT_TRUE(bus.check());
+    TEST_ASSERT_EQUAL_UINT8(9, clocks);
+    TEST_ASSERT_EQUAL_UINT16(1, Wire.begins);
+}
+
+void test_timeouts_saturate()
+{
+    I2cBus bus;
+    for (uint32_t i = 0; i < 0x10001UL; ++i)
+    {
+        Wire.timeout_flag = true;
+        bus.check();
+    }
+    TEST_ASSERT_EQUAL_UINT16(0xffff, bus.timeouts());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_setup_sets_clock_and_timeout);
+    RUN_TEST(test_check_without_timeout_does_nothing);
+    RUN_TEST(test_timeout_is_reported_once_and_recovered);
+    RUN_TEST(test_recovery_clocks_until_sda_released);
+    RUN_TEST(test_recovery_gives_up_after_nine_clocks);
+    RUN_TEST(test_timeouts_saturate);
+    return UNITY_END();
+}
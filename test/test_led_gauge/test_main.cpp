@@ -0,0 +1,194 @@
+#include "LedGauge.h"
+#include <unity.h>
+
+using namespace led_palette;
+
+static uint8_t frame[NUM_PIXEL];
+
+// show \p count frames of \p effect, then render the next one into frame
+static void advance(LedGauge& gauge, LedEffect effect, int16_t value, uint8_t count = 1)
+{
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        gauge.update(effect, value);
+    }
+    gauge.render(frame, value);
+}
+
+static void assertFrame(const uint8_t (&expected)[NUM_PIXEL])
+{
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame, NUM_PIXEL);
+}
+
+static void assertAll(uint8_t index)
+{
+    for (uint8_t i = 0; i < NUM_PIXEL; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(index, frame[i]);
+    }
+}
+
+// strip refreshes since the timer was reset: each show() bumps the timer by the frame time
+static uint32_t shows() { return Timer::instance().get_count() / (NUM_PIXEL * 30 * COUNT_PER_MICROS); }
+
+void setUp()
+{
+    Timer::instance().reset();
+    TIFR2 = 0;  // write-one-to-clear on the target, a plain variable here
+}
+
+void tearDown() {}
+
+void test_gamma_endpoints_and_monotony()
+{
+    TEST_ASSERT_EQUAL_UINT8(0, gamma8(0));
+    TEST_ASSERT_EQUAL_UINT8(255, gamma8(255));
+    // 255 * 0.5^2.5
+    TEST_ASSERT_UINT8_WITHIN(1, 45, gamma8(128));
+    for (uint16_t v = 1; v < 256; ++v)
+    {
+        TEST_ASSERT_TRUE(gamma8(static_cast<uint8_t>(v)) >= gamma8(static_cast<uint8_t>(v - 1)));
+    }
+}
+
+void test_palette_colors()
+{
+    TEST_ASSERT_EQUAL_HEX32(0x00ff00, wheel(0));
+    TEST_ASSERT_EQUAL_HEX32(0xff0000, wheel(85));
+    TEST_ASSERT_EQUAL_HEX32(0x0000ff, wheel(170));
+    TEST_ASSERT_EQUAL_HEX32(0x00ff00, pgm_read_dword(&PALETTE[WHEEL]));
+    TEST_ASSERT_EQUAL_HEX32(0, pgm_read_dword(&PALETTE[OFF]));
+    TEST_ASSERT_EQUAL_HEX32(0xff0000, pgm_read_dword(&PALETTE[RED]));
+    TEST_ASSERT_EQUAL_HEX32(0x0000ff, pgm_read_dword(&PALETTE[BLUE]));
+    TEST_ASSERT_EQUAL_HEX32(0x0000ff, pgm_read_dword(&PALETTE[BREATHE + BREATHE_SIZE - 1]));
+    TEST_ASSERT_EQUAL_HEX32(color(0x00, 0x8b, 0x00), pgm_read_dword(&PALETTE[CHARGE + NUM_PIXEL - 1]));
+}
+
+void test_rainbow_spreads_and_turns()
+{
+    LedGauge gauge(6);
+    gauge.render(frame, 0);
+    const uint8_t first[NUM_PIXEL] = {0, 6, 12, 19, 25};
+    assertFrame(first);
+
+    // one wheel step every two frames, wrapping around the wheel
+    advance(gauge, LedEffect::Rainbow, 0, 2);
+    const uint8_t turned[NUM_PIXEL] = {1, 7, 13, 20, 26};
+    assertFrame(turned);
+    advance(gauge, LedEffect::Rainbow, 0, 12);
+    TEST_ASSERT_EQUAL_UINT8(WHEEL + 0, frame[4]);
+}
+
+void test_bars()
+{
+    LedGauge gauge(6);
+    advance(gauge, LedEffect::Bars, 2);
+    const uint8_t expected[NUM_PIXEL] = {RED, RED, BLUE, BLUE, BLUE};
+    assertFrame(expected);
+    advance(gauge, LedEffect::Bars, 0);
+    assertAll(BLUE);
+}
+
+void test_charge_bars_with_hysteresis()
+{
+    LedGauge gauge(6);
+    advance(gauge, LedEffect::Charge, 100);
+    assertAll(CHARGE + 4);
+
+    advance(gauge, LedEffect::Charge, 50);
+    const uint8_t three[NUM_PIXEL] = {CHARGE + 2, CHARGE + 2, CHARGE + 2, OFF, OFF};
+    assertFrame(three);
+
+    // down below the level, up only 2 % above it
+    advance(gauge, LedEffect::Charge, 40);
+    assertFrame(three);
+    advance(gauge, LedEffect::Charge, 39);
+    TEST_ASSERT_EQUAL_UINT8(OFF, frame[2]);
+    advance(gauge, LedEffect::Charge, 41);
+    TEST_ASSERT_EQUAL_UINT8(OFF, frame[2]);
+    advance(gauge, LedEffect::Charge, 42);
+    assertFrame(three);
+
+    advance(gauge, LedEffect::Charge, 0);
+    const uint8_t one[NUM_PIXEL] = {CHARGE, OFF, OFF, OFF, OFF};
+    assertFrame(one);
+}
+
+void test_low_battery_blinks()
+{
+    LedGauge gauge(6);
+    gauge.update(LedEffect::LowBattery, 10);
+    gauge.render(frame, 10);
+    TEST_ASSERT_EQUAL_UINT8(CHARGE, frame[0]);
+    TEST_ASSERT_EQUAL_UINT8(OFF, frame[1]);
+
+    // 16 frames on, 16 off
+    advance(gauge, LedEffect::LowBattery, 10, 15);
+    assertAll(OFF);
+    advance(gauge, LedEffect::LowBattery, 10, 16);
+    TEST_ASSERT_EQUAL_UINT8(CHARGE, frame[0]);
+}
+
+void test_calibrating_breathes()
+{
+    LedGauge gauge(6);
+    gauge.update(LedEffect::Calibrating);
+
+    // phase 1 .. 32: two frames per step, up the ramp and back down
+    for (uint8_t phase = 1; phase <= 32; ++phase)
+    {
+        gauge.render(frame, 0);
+        uint8_t step = (phase >> 1) & 15;
+        assertAll(BREATHE + (step < 8 ? step : 15 - step));
+        gauge.update(LedEffect::Calibrating);
+    }
+}
+
+void test_fail_safe_blinks_red()
+{
+    LedGauge gauge(6);
+    advance(gauge, LedEffect::FailSafe, 0);
+    assertAll(RED);
+    advance(gauge, LedEffect::FailSafe, 0, 15);
+    assertAll(OFF);
+}
+
+void test_effect_change_restarts_animation()
+{
+    LedGauge gauge(6);
+    advance(gauge, LedEffect::FailSafe, 0, 20);
+    assertAll(OFF);
+
+    // a new effect starts at phase 0, so fail-safe starts with red again
+    advance(gauge, LedEffect::Bars, 1);
+    advance(gauge, LedEffect::FailSafe, 0);
+    assertAll(RED);
+}
+
+void test_strip_refreshed_only_on_change()
+{
+    LedGauge gauge(6);
+    gauge.update(LedEffect::Bars, 2);
+    TEST_ASSERT_EQUAL_UINT32(1, shows());
+    gauge.update(LedEffect::Bars, 2);
+    gauge.update(LedEffect::Bars, 2);
+    TEST_ASSERT_EQUAL_UINT32(1, shows());
+    gauge.update(LedEffect::Bars, 3);
+    TEST_ASSERT_EQUAL_UINT32(2, shows());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_gamma_endpoints_and_monotony);
+    RUN_TEST(test_palette_colors);
+    RUN_TEST(test_rainbow_spreads_and_turns);
+    RUN_TEST(test_bars);
+    RUN_TEST(test_charge_bars_with_hysteresis);
+    RUN_TEST(test_low_battery_blinks);
+    RUN_TEST(test_calibrating_breathes);
+    RUN_TEST(test_fail_safe_blinks_red);
+    RUN_TEST(test_effect_change_restarts_animation);
+    RUN_TEST(test_strip_refreshed_only_on_change);
+    return UNITY_END();
+}
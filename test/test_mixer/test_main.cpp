@@ -0,0 +1,108 @@
+#include "Mixer.h"
+#include <unity.h>
+
+enum Output : uint8_t
+{
+    RIGHT_FAN,
+    LEFT_FAN,
+    HOVER_FAN,
+    RUDDER,
+    HALF,
+    COUNT
+};
+
+// the firmware's fan rows, the rudder row of the Mixer documentation and a row with fractional weights
+constexpr MixerRow ROWS[COUNT] = {
+    {64, -64, 0, 1477, 1020, 1980},
+    {64, 64, 0, 1480, 1020, 1980},
+    {0, 0, 64, 1000, 1000, 2000},
+    {0, 64, 0, 1500, 1100, 1900},
+    {32, -16, 96, 1500, 1000, 2000},
+};
+typedef Mixer<COUNT, ROWS> TestMixer;
+
+// evaluated at compile time
+constexpr MixerInput FULL_LEFT = {0, 400, 0};
+static_assert(TestMixer::mix<LEFT_FAN>(FULL_LEFT) == 400, "mix is a constant expression");
+static_assert(TestMixer::output<RUDDER>(TestMixer::mix<RUDDER>(FULL_LEFT)) == 1900, "output is a constant expression");
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_neutral_input_gives_trim()
+{
+    const MixerInput in = {0, 0, 0};
+    TEST_ASSERT_EQUAL_INT16(0, TestMixer::mix<RIGHT_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(1477, TestMixer::output<RIGHT_FAN>(TestMixer::mix<RIGHT_FAN>(in)));
+    TEST_ASSERT_EQUAL_INT16(1480, TestMixer::output<LEFT_FAN>(TestMixer::mix<LEFT_FAN>(in)));
+    TEST_ASSERT_EQUAL_INT16(1000, TestMixer::output<HOVER_FAN>(TestMixer::mix<HOVER_FAN>(in)));
+    TEST_ASSERT_EQUAL_INT16(1477, TestMixer::trim<RIGHT_FAN>());
+    TEST_ASSERT_EQUAL_INT16(1000, TestMixer::trim<HOVER_FAN>());
+}
+
+void test_thrust_drives_both_fans()
+{
+    const MixerInput in = {200, 0, 0};
+    TEST_ASSERT_EQUAL_INT16(200, TestMixer::mix<RIGHT_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(200, TestMixer::mix<LEFT_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(0, TestMixer::mix<HOVER_FAN>(in));
+}
+
+void test_yaw_is_differential()
+{
+    // counter-clockwise: left fan faster, right fan slower
+    const MixerInput in = {100, 50, 0};
+    TEST_ASSERT_EQUAL_INT16(50, TestMixer::mix<RIGHT_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(150, TestMixer::mix<LEFT_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(1527, TestMixer::output<RIGHT_FAN>(TestMixer::mix<RIGHT_FAN>(in)));
+    TEST_ASSERT_EQUAL_INT16(1630, TestMixer::output<LEFT_FAN>(TestMixer::mix<LEFT_FAN>(in)));
+}
+
+void test_hover_only_drives_hover_fan()
+{
+    const MixerInput in = {0, 0, 450};
+    TEST_ASSERT_EQUAL_INT16(450, TestMixer::mix<HOVER_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(0, TestMixer::mix<RIGHT_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(1450, TestMixer::output<HOVER_FAN>(TestMixer::mix<HOVER_FAN>(in)));
+}
+
+void test_fractional_weights()
+{
+    // 0.5 * 100 - 0.25 * 40 + 1.5 * 20
+    const MixerInput in = {100, 40, 20};
+    TEST_ASSERT_EQUAL_INT16(70, TestMixer::mix<HALF>(in));
+
+    // the sum is shifted once, so it rounds towards minus infinity: 0.5 * -3 = -1.5 -> -2
+    const MixerInput odd = {-3, 0, 0};
+    TEST_ASSERT_EQUAL_INT16(-2, TestMixer::mix<HALF>(odd));
+}
+
+void test_output_is_limited()
+{
+    TEST_ASSERT_EQUAL_INT16(1980, TestMixer::output<RIGHT_FAN>(600));
+    TEST_ASSERT_EQUAL_INT16(1020, TestMixer::output<RIGHT_FAN>(-600));
+    TEST_ASSERT_EQUAL_INT16(1980, TestMixer::output<RIGHT_FAN>(1980 - 1477));
+    TEST_ASSERT_EQUAL_INT16(1100, TestMixer::output<RUDDER>(-400));
+}
+
+void test_large_inputs_do_not_overflow()
+{
+    // products exceed int16_t before the shift
+    const MixerInput in = {20000, 20000, 0};
+    TEST_ASSERT_EQUAL_INT16(0, TestMixer::mix<RIGHT_FAN>(in));
+    TEST_ASSERT_EQUAL_INT16(-20000 / 4 + 20000 / 2, TestMixer::mix<HALF>(in));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_neutral_input_gives_trim);
+    RUN_TEST(test_thrust_drives_both_fans);
+    RUN_TEST(test_yaw_is_differential);
+    RUN_TEST(test_hover_only_drives_hover_fan);
+    RUN_TEST(test_fractional_weights);
+    RUN_TEST(test_output_is_limited);
+    RUN_TEST(test_large_inputs_do_not_overflow);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+#include "Motor.h"
+#include <new>
+#include <unity.h>
+
+static constexpr uint16_t MID = 1500;
+static constexpr uint16_t NO_STEP_LIMIT = 1000;
+static const Range RANGE = {1100, 1900};
+
+static Motor motor(9, RANGE);
+static Tachometer* tach;
+static uint32_t now;  // [timer counts]
+
+// run the tachometer at \p rpm (7 pulses per revolution) through two updates
+static void spin(uint16_t rpm)
+{
+    uint32_t period = 60000000UL * COUNT_PER_MICROS / 7 / rpm;
+    for (uint8_t update = 0; update < 2; ++update)
+    {
+        for (uint8_t i = 0; i < 4; ++i)
+        {
+            now += period;
+            tach->edges(bit(5), now);
+        }
+        tach->update(now);
+    }
+}
+
+void setUp()
+{
+    alignas(Tachometer) static uint8_t storage[sizeof(Tachometer)];
+    tach = new (storage) Tachometer(5, 7);
+    now = 0;
+    motor.setTachometer(nullptr);
+    motor.setRpm(0, MID, MID, NO_STEP_LIMIT);  // resets the trim
+    motor.set(MID);
+}
+
+void tearDown() {}
+
+void test_set_clamps_to_range()
+{
+    motor.set(2000);
+    TEST_ASSERT_EQUAL_INT(1900, motor.value());
+    motor.set(1000);
+    TEST_ASSERT_EQUAL_INT(1100, motor.value());
+    motor.set(1000, false);
+    TEST_ASSERT_EQUAL_INT(1000, motor.value());
+}
+
+void test_filter_limits_steps_away_from_mid()
+{
+    motor.setFiltered(1800, MID, 100);
+    TEST_ASSERT_EQUAL_INT(1600, motor.value());
+    motor.setFiltered(1800, MID, 100);
+    TEST_ASSERT_EQUAL_INT(1700, motor.value());
+
+    // towards mid at once
+    motor.setFiltered(MID, MID, 100);
+    TEST_ASSERT_EQUAL_INT(MID, motor.value());
+
+    motor.setFiltered(1200, MID, 100);
+    TEST_ASSERT_EQUAL_INT(1400, motor.value());
+}
+
+void test_open_loop_without_tachometer()
+{
+    motor.setRpm(5000, 1700, MID, NO_STEP_LIMIT);
+    TEST_ASSERT_EQUAL_INT(1700, motor.value());
+    TEST_ASSERT_EQUAL_INT16(0, motor.rpmTrim());
+    TEST_ASSERT_EQUAL_UINT16(0, motor.rpm());
+}
+
+void test_trim_raises_slow_fan()
+{
+    motor.setTachometer(tach);
+    spin(4000);
+    TEST_ASSERT_UINT16_WITHIN(1, 4000, motor.rpm());
+
+    // 1000 rpm too slow: +15/16 us per frame
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        motor.setRpm(5000, 1700, MID, NO_STEP_LIMIT);
+    }
+    TEST_ASSERT_TRUE(motor.rpmTrim() > 0);
+    TEST_ASSERT_EQUAL_INT(1700 + motor.rpmTrim(), motor.value());
+}
+
+void test_trim_acts_away_from_mid_in_reverse()
+{
+    motor.setTachometer(tach);
+    spin(4000);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        motor.setRpm(5000, 1300, MID, NO_STEP_LIMIT);
+    }
+    TEST_ASSERT_TRUE(motor.rpmTrim() > 0);
+    TEST_ASSERT_EQUAL_INT(1300 - motor.rpmTrim(), motor.value());
+}
+
+void test_trim_never_reverses_the_fan()
+{
+    motor.setTachometer(tach);
+    spin(8000);
+
+    // far too fast for a command just above mid: the negative trim stops at mid
+    for (uint8_t i = 0; i < 255; ++i)
+    {
+        motor.setRpm(1000, MID + 10, MID, NO_STEP_LIMIT);
+    }
+    TEST_ASSERT_TRUE(motor.rpmTrim() < -10);
+    TEST_ASSERT_EQUAL_INT(MID, motor.value());
+
+    // the same below mid
+    for (uint8_t i = 0; i < 255; ++i)
+    {
+        motor.setRpm(1000, MID - 10, MID, NO_STEP_LIMIT);
+    }
+    TEST_ASSERT_EQUAL_INT(MID, motor.value());
+}
+
+void test_trim_is_limited()
+{
+    motor.setTachometer(tach);
+    spin(1000);
+    for (uint16_t i = 0; i < 2000; ++i)
+    {
+        motor.setRpm(9000, 1600, MID, NO_STEP_LIMIT);
+    }
+    TEST_ASSERT_EQUAL_INT16(50, motor.rpmTrim());
+    TEST_ASSERT_EQUAL_INT(1650, motor.value());
+}
+
+void test_zero_target_resets_trim()
+{
+    motor.setTachometer(tach);
+    spin(4000);
+    for (uint8_t i = 0; i < 32; ++i)
+    {
+        motor.setRpm(5000, 1700, MID, NO_STEP_LIMIT);
+    }
+    TEST_ASSERT_TRUE(motor.rpmTrim() != 0);
+
+    motor.setRpm(0, 1700, MID, NO_STEP_LIMIT);
+    TEST_ASSERT_EQUAL_INT16(0, motor.rpmTrim());
+    TEST_ASSERT_EQUAL_INT(1700, motor.value());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_set_clamps_to_range);
+    RUN_TEST(test_filter_limits_steps_away_from_mid);
+    RUN_TEST(test_open_loop_without_tachometer);
+    RUN_TEST(test_trim_raises_slow_fan);
+    RUN_TEST(test_trim_acts_away_from_mid_in_reverse);
+    RUN_TEST(test_trim_never_reverses_the_fan);
+    RUN_TEST(test_trim_is_limited);
+    RUN_TEST(test_zero_target_resets_trim);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+#include "PinChange.h"
+#include <unity.h>
+
+struct Edge
+{
+    uint8_t pin;
+    bool high;
+    uint32_t now;
+};
+
+static Edge edges[16];
+static uint8_t edge_count;
+
+template <uint8_t PIN>
+void handler(bool high, uint32_t now)
+{
+    if (edge_count < 16)
+    {
+        edges[edge_count++] = {PIN, high, now};
+    }
+}
+
+void setUp()
+{
+    // handlers stay attached between tests: bring all ports back to low first
+    for (uint8_t port = 0; port < PinChange::PORT_COUNT; ++port)
+    {
+        PinChange::dispatch(port, 0, 0);
+    }
+    edge_count = 0;
+    PCICR = 0;
+    PCIFR = 0;
+    PCMSK0 = PCMSK1 = PCMSK2 = 0;
+}
+
+void tearDown() {}
+
+void test_attach_enables_interrupts()
+{
+    PIND = 0;
+    PinChange::attach(2, handler<2>);
+    TEST_ASSERT_EQUAL_HEX8(bit(2), PCMSK2);
+    TEST_ASSERT_EQUAL_HEX8(bit(2), PCICR);
+
+    PINC = 0;
+    PinChange::attach(A1, handler<A1>);
+    TEST_ASSERT_EQUAL_HEX8(bit(1), PCMSK1);
+    TEST_ASSERT_EQUAL_HEX8(bit(2) | bit(1), PCICR);
+
+    PinChange::attach(9, handler<9>);
+    TEST_ASSERT_EQUAL_HEX8(bit(1), PCMSK0);
+    TEST_ASSERT_EQUAL_HEX8(bit(2) | bit(1) | bit(0), PCICR);
+}
+
+void test_dispatch_calls_handler_per_edge()
+{
+    PIND = 0;
+    PinChange::attach(3, handler<3>);
+
+    PinChange::dispatch(2, bit(3), 1000);
+    PinChange::dispatch(2, 0, 4000);
+    TEST_ASSERT_EQUAL_UINT8(2, edge_count);
+    TEST_ASSERT_EQUAL_UINT8(3, edges[0].pin);
+    TEST_ASSERT_TRUE(edges[0].high);
+    TEST_ASSERT_EQUAL_UINT32(1000, edges[0].now);
+    TEST_ASSERT_FALSE(edges[1].high);
+    TEST_ASSERT_EQUAL_UINT32(4000, edges[1].now);
+}
+
+void test_attach_does_not_report_present_level()
+{
+    // pin already high when attached: no edge until it changes
+    PIND = bit(4);
+    PinChange::attach(4, handler<4>);
+    PinChange::dispatch(2, bit(4), 100);
+    TEST_ASSERT_EQUAL_UINT8(0, edge_count);
+    PinChange::dispatch(2, 0, 200);
+    TEST_ASSERT_EQUAL_UINT8(1, edge_count);
+    TEST_ASSERT_FALSE(edges[0].high);
+}
+
+void test_simultaneous_edges_share_timestamp()
+{
+    PIND = 0;
+    PinChange::attach(2, handler<2>);
+    PinChange::attach(3, handler<3>);
+    PinChange::attach(4, handler<4>);
+
+    // 2 and 4 rise together, in bit order
+    PinChange::dispatch(2, bit(2) | bit(4), 777);
+    TEST_ASSERT_EQUAL_UINT8(2, edge_count);
+    TEST_ASSERT_EQUAL_UINT8(2, edges[0].pin);
+    TEST_ASSERT_EQUAL_UINT8(4, edges[1].pin);
+    TEST_ASSERT_EQUAL_UINT32(777, edges[0].now);
+    TEST_ASSERT_EQUAL_UINT32(777, edges[1].now);
+}
+
+void test_unattached_pins_are_ignored()
+{
+    PIND = 0;
+    PinChange::attach(2, handler<2>);
+    // pins 0, 1 and 5..7 toggle (e.g. the serial port)
+    PinChange::dispatch(2, 0xe3, 10);
+    PinChange::dispatch(2, 0x00, 20);
+    TEST_ASSERT_EQUAL_UINT8(0, edge_count);
+}
+
+void test_ports_are_independent()
+{
+    PIND = 0;
+    PINB = 0;
+    PinChange::attach(2, handler<2>);
+    PinChange::attach(10, handler<10>);
+
+    // bit 2 on port B is pin 10, not pin 2
+    PinChange::dispatch(0, bit(2), 50);
+    TEST_ASSERT_EQUAL_UINT8(1, edge_count);
+    TEST_ASSERT_EQUAL_UINT8(10, edges[0].pin);
+}
+
+// last: the port C pins stay attached without handler, which setUp() must not dispatch
+void test_rising_reports_rising_edges_only()
+{
+    // attached without handler, as the fan tachometers on port C
+    PINC = 0;
+    PinChange::attach(A0);
+    PinChange::attach(A1);
+    TEST_ASSERT_EQUAL_HEX8(bit(0) | bit(1), PCMSK1);
+
+    TEST_ASSERT_EQUAL_HEX8(bit(0), PinChange::rising(1, bit(0)));
+    TEST_ASSERT_EQUAL_HEX8(bit(1), PinChange::rising(1, bit(0) | bit(1)));
+    TEST_ASSERT_EQUAL_HEX8(0, PinChange::rising(1, bit(1)));
+    TEST_ASSERT_EQUAL_HEX8(0, PinChange::rising(1, 0));
+    TEST_ASSERT_EQUAL_HEX8(bit(0) | bit(1), PinChange::rising(1, bit(0) | bit(1)));
+
+    // unattached pins of the port are ignored
+    TEST_ASSERT_EQUAL_HEX8(0, PinChange::rising(1, bit(0) | bit(1) | bit(2)));
+    TEST_ASSERT_EQUAL_UINT8(0, edge_count);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_attach_enables_interrupts);
+    RUN_TEST(test_dispatch_calls_handler_per_edge);
+    RUN_TEST(test_attach_does_not_report_present_level);
+    RUN_TEST(test_simultaneous_edges_share_timestamp);
+    RUN_TEST(test_unattached_pins_are_ignored);
+    RUN_TEST(test_ports_are_independent);
+    RUN_TEST(test_rising_reports_rising_edges_only);
+    return UNITY_END();
+}
@@ -0,0 +1,170 @@
+#include "PowerMonitor.h"
+#include <unity.h>
+
+static constexpr uint8_t ADDRESS = 0x44;
+static constexpr uint32_t MS = 1000UL * COUNT_PER_MICROS;
+
+// INA219 register contents for a measurement
+static void measure(TwoWire::Device& ina, int16_t mv, int16_t ma, bool ready = true)
+{
+    ina.reg[0x02] = static_cast<uint16_t>((mv / 4) << 3) | (ready ? 0x0002 : 0);
+    ina.reg[0x04] = static_cast<uint16_t>(ma);
+    ina.reg[0x03] = static_cast<uint16_t>((static_cast<int32_t>(mv) * ma / 1000) / 20);
+}
+
+void setUp() { Wire = TwoWire(); }
+void tearDown() {}
+
+void test_setup_writes_calibration_and_config()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+
+    // 1 mA current LSB with a 100 mOhm shunt
+    TEST_ASSERT_EQUAL_UINT16(409, ina.reg[0x05]);
+    // 32 V, 320 mV, 4 sample bus and 16 sample shunt averaging, triggered
+    TEST_ASSERT_EQUAL_HEX32(0x3d63, ina.reg[0x00]);
+}
+
+void test_waits_for_conversion_time()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+    measure(ina, 8000, 2000);
+
+    // 2.13 + 8.51 ms conversion
+    TEST_ASSERT_FALSE(monitor.poll(10 * MS));
+    TEST_ASSERT_TRUE(monitor.poll(11 * MS));
+    TEST_ASSERT_EQUAL_INT16(8000, monitor.voltage());
+    TEST_ASSERT_EQUAL_INT16(2000, monitor.current());
+    TEST_ASSERT_UINT32_WITHIN(20, 16000, monitor.power());
+
+    // next conversion triggered by the read
+    TEST_ASSERT_FALSE(monitor.poll(12 * MS));
+}
+
+void test_waits_for_conversion_ready()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+    measure(ina, 8000, 2000, false);
+
+    TEST_ASSERT_FALSE(monitor.poll(20 * MS));
+    measure(ina, 8000, 2000, true);
+    TEST_ASSERT_TRUE(monitor.poll(21 * MS));
+}
+
+void test_bus_errors_keep_last_reading()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+    measure(ina, 7400, 1500);
+    TEST_ASSERT_TRUE(monitor.poll(20 * MS));
+
+    Wire.hung = true;
+    measure(ina, 7000, 9000);
+    TEST_ASSERT_FALSE(monitor.poll(40 * MS));
+    TEST_ASSERT_EQUAL_INT16(7400, monitor.voltage());
+    TEST_ASSERT_EQUAL_INT16(1500, monitor.current());
+}
+
+void test_missing_device()
+{
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+    TEST_ASSERT_FALSE(monitor.poll(20 * MS));
+}
+
+void test_integrates_consumed_charge()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+    measure(ina, 8000, 3600);
+
+    // 3.6 A for 100 s at 20 ms per sample
+    uint32_t now = 0;
+    for (uint16_t i = 0; i < 5000; ++i)
+    {
+        now += 20 * MS;
+        TEST_ASSERT_TRUE(monitor.poll(now));
+    }
+    TEST_ASSERT_UINT16_WITHIN(1, 100, monitor.consumed());
+}
+
+void test_charging_current_is_not_integrated()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+    measure(ina, 8000, -2000);
+
+    uint32_t now = 0;
+    for (uint16_t i = 0; i < 1000; ++i)
+    {
+        now += 20 * MS;
+        monitor.poll(now);
+    }
+    TEST_ASSERT_EQUAL_INT16(-2000, monitor.current());
+    TEST_ASSERT_EQUAL_UINT16(0, monitor.consumed());
+}
+
+void test_conversion_model_clears_ready()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    ina.ina219 = true;
+    measure(ina, 8000, 2000, false);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+
+    // the configuration write of setup() started the conversion
+    TEST_ASSERT_TRUE(monitor.poll(11 * MS));
+    TEST_ASSERT_TRUE(monitor.poll(22 * MS));
+    TEST_ASSERT_TRUE(monitor.poll(33 * MS));
+    TEST_ASSERT_EQUAL_UINT16(0, monitor.retriggers());
+}
+
+void test_failed_trigger_is_retried()
+{
+    TwoWire::Device& ina = Wire.attach(ADDRESS);
+    ina.ina219 = true;
+    measure(ina, 8000, 2000, false);
+    PowerMonitor monitor(ADDRESS, 100);
+    monitor.setup();
+
+    // the trigger after this reading is not acknowledged: the device stays idle
+    Wire.failed_writes = 1;
+    TEST_ASSERT_TRUE(monitor.poll(11 * MS));
+    TEST_ASSERT_EQUAL_UINT8(0, Wire.failed_writes);
+    TEST_ASSERT_EQUAL_HEX32(0, ina.reg[0x02] & 0x0002);
+
+    // not ready, but not yet overdue (two conversion times since the last successful trigger)
+    TEST_ASSERT_FALSE(monitor.poll(15 * MS));
+    TEST_ASSERT_EQUAL_UINT16(0, monitor.retriggers());
+
+    // overdue: the conversion is started again and read once its time passed
+    TEST_ASSERT_FALSE(monitor.poll(22 * MS));
+    TEST_ASSERT_EQUAL_UINT16(1, monitor.retriggers());
+    TEST_ASSERT_FALSE(monitor.poll(30 * MS));
+    TEST_ASSERT_TRUE(monitor.poll(33 * MS));
+    TEST_ASSERT_TRUE(monitor.poll(44 * MS));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_setup_writes_calibration_and_config);
+    RUN_TEST(test_waits_for_conversion_time);
+    RUN_TEST(test_waits_for_conversion_ready);
+    RUN_TEST(test_bus_errors_keep_last_reading);
+    RUN_TEST(test_missing_device);
+    RUN_TEST(test_integrates_consumed_charge);
+    RUN_TEST(test_charging_current_is_not_integrated);
+    RUN_TEST(test_conversion_model_clears_ready);
+    RUN_TEST(test_failed_trigger_is_retried);
+    return UNITY_END();
+}
@@ -0,0 +1,267 @@
+#include "RcChannel.h"
+#include <algorithm>
+#include <stdlib.h>
+#include <unity.h>
+
+static constexpr uint32_t US = COUNT_PER_MICROS;
+static constexpr uint32_t TIMEOUT = 100000UL * US;
+
+// one pulse of \p length_us starting at \p start; returns the falling edge result
+static bool pulse(RcChannel& channel, uint32_t start, uint16_t length_us)
+{
+    channel.rx(true, start);
+    return channel.rx(false, start + length_us * US);
+}
+
+// control cycles without frames, every 25 ms (PWM refresh) from \p from until before \p to
+static void idle(RcChannel& channel, uint32_t from, uint32_t to)
+{
+    for (uint32_t now = from; now < to; now += 25000 * US)
+    {
+        channel.expire(now);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_valid_pulse()
+{
+    RcChannel channel(2, 1500 * US);
+    TEST_ASSERT_TRUE(pulse(channel, 1000, 1200));
+
+    uint16_t length;
+    TEST_ASSERT_TRUE(channel.take(length));
+    TEST_ASSERT_EQUAL_UINT16(1200 * US, length);
+    TEST_ASSERT_FALSE(channel.take(length));
+    TEST_ASSERT_EQUAL_UINT8(0, channel.glitches());
+}
+
+void test_out_of_range_pulses_are_glitches()
+{
+    RcChannel channel(2, 1500 * US);
+    uint16_t length;
+
+    TEST_ASSERT_TRUE(pulse(channel, 0, 500));
+    TEST_ASSERT_FALSE(channel.take(length));
+    TEST_ASSERT_TRUE(pulse(channel, 20000 * US, 2500));
+    TEST_ASSERT_FALSE(channel.take(length));
+    TEST_ASSERT_EQUAL_UINT8(2, channel.glitches());
+
+    // limits are valid
+    TEST_ASSERT_TRUE(pulse(channel, 40000 * US, 800));
+    TEST_ASSERT_TRUE(channel.take(length));
+    TEST_ASSERT_TRUE(pulse(channel, 60000 * US, 2200));
+    TEST_ASSERT_TRUE(channel.take(length));
+}
+
+void test_fast_rising_edges_are_noise()
+{
+    RcChannel channel(2, 1500 * US);
+    pulse(channel, 0, 1500);
+    // a rising edge 2 ms after the last one
+    channel.rx(true, 2000 * US);
+    TEST_ASSERT_EQUAL_UINT8(1, channel.glitches());
+    // its falling edge is ignored
+    TEST_ASSERT_FALSE(channel.rx(false, 3000 * US));
+
+    uint16_t length;
+    channel.take(length);
+    TEST_ASSERT_TRUE(pulse(channel, 20000 * US, 1500));
+    TEST_ASSERT_TRUE(channel.take(length));
+}
+
+void test_gap_across_16_bit_wrap()
+{
+    // the 16-bit start time wraps every 32.768 ms; gaps a little longer than that are still valid frames
+    static const uint32_t GAPS_US[] = {32768, 33000, 35000, 35700, 65600, 67000, 100000};
+    for (uint8_t i = 0; i < sizeof(GAPS_US) / sizeof(GAPS_US[0]); ++i)
+    {
+        RcChannel channel(2, 1500 * US);
+        uint16_t length;
+        uint32_t start = 12345;
+        pulse(channel, start, 1500);
+        channel.take(length);
+        idle(channel, start + 2000 * US, start + GAPS_US[i] * US);
+
+        TEST_ASSERT_TRUE(pulse(channel, start + GAPS_US[i] * US, 1600));
+        TEST_ASSERT_TRUE(channel.take(length));
+        TEST_ASSERT_EQUAL_UINT16(1600 * US, length);
+        TEST_ASSERT_EQUAL_UINT8(0, channel.glitches());
+    }
+}
+
+void test_started_pulse_across_wrap()
+{
+    // a pulse started by start() whose falling edge never came does not swallow the next frame 32.8 ms later
+    RcChannel channel(2, 1500 * US);
+    channel.start(1000);
+    uint32_t next = 1000 + 33000 * US;
+    idle(channel, 1000 + 2000 * US, next);
+    TEST_ASSERT_EQUAL_UINT8(1, channel.glitches());
+
+    // its late falling edge would measure 1.5 ms across the wrap
+    uint32_t late = 1000 + 34268 * US;
+    TEST_ASSERT_FALSE(channel.rx(false, late));
+    TEST_ASSERT_TRUE(pulse(channel, next + 20000 * US, 1400));
+
+    uint16_t length;
+    TEST_ASSERT_TRUE(channel.take(length));
+    TEST_ASSERT_EQUAL_UINT16(1400 * US, length);
+}
+
+void test_expire_keeps_recent_start()
+{
+    // a control cycle within the minimum period: the next edge is still noise, and the running pulse completes
+    RcChannel channel(2, 1500 * US);
+    channel.rx(true, 0);
+    channel.expire(1000 * US);
+    TEST_ASSERT_TRUE(channel.rx(false, 1500 * US));
+    channel.expire(2000 * US);
+    channel.rx(true, 2500 * US);
+    TEST_ASSERT_EQUAL_UINT8(1, channel.glitches());
+
+    uint16_t length;
+    TEST_ASSERT_TRUE(channel.take(length));
+    TEST_ASSERT_EQUAL_UINT16(1500 * US, length);
+}
+
+void test_back_to_back_start()
+{
+    // the previous channel's falling edge starts this pulse, its own rising edge comes late
+    RcChannel channel(3, 1500 * US);
+    channel.start(0);
+    channel.rx(true, 20 * US);
+    TEST_ASSERT_TRUE(channel.rx(false, 1500 * US));
+
+    uint16_t length;
+    TEST_ASSERT_TRUE(channel.take(length));
+    TEST_ASSERT_EQUAL_UINT16(1500 * US, length);
+    TEST_ASSERT_EQUAL_UINT8(0, channel.glitches());
+}
+
+void test_falling_edge_without_start()
+{
+    RcChannel channel(2, 1500 * US);
+    TEST_ASSERT_FALSE(channel.rx(false, 1000));
+    uint16_t length;
+    TEST_ASSERT_FALSE(channel.take(length));
+}
+
+void test_valid_times_out()
+{
+    RcChannel channel(2, 1500 * US);
+    TEST_ASSERT_FALSE(channel.valid(1000, TIMEOUT));
+
+    channel.update(1500 * US, true, 1000);
+    TEST_ASSERT_TRUE(channel.valid(1000 + TIMEOUT - 1, TIMEOUT));
+    TEST_ASSERT_FALSE(channel.valid(1000 + TIMEOUT, TIMEOUT));
+
+    // stale frames do not refresh
+    channel.update(1500 * US, false, 1000 + TIMEOUT);
+    TEST_ASSERT_FALSE(channel.valid(1000 + TIMEOUT, TIMEOUT));
+}
+
+template <uint8_t N>
+static uint16_t sorted_median(const uint16_t (&h)[N])
+{
+    uint16_t s[N];
+    std::copy(h, h + N, s);
+    std::sort(s, s + N);
+    return s[N / 2];
+}
+
+void test_median3_all_orders()
+{
+    // all orderings of three values, with ties
+    static const uint16_t VALUES[][3] = {{1, 2, 3}, {1, 1, 2}, {1, 2, 2}, {5, 5, 5}, {0, 65535, 1000}};
+    static const uint8_t ORDERS[][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+    for (uint8_t v = 0; v < sizeof(VALUES) / sizeof(VALUES[0]); ++v)
+    {
+        for (uint8_t o = 0; o < 6; ++o)
+        {
+            uint16_t h[3] = {VALUES[v][ORDERS[o][0]], VALUES[v][ORDERS[o][1]], VALUES[v][ORDERS[o][2]]};
+            TEST_ASSERT_EQUAL_UINT16(sorted_median(h), RcChannel::median(h));
+        }
+    }
+}
+
+void test_median5_all_orders()
+{
+    // every permutation of 5 distinct values, and of values with ties
+    static const uint16_t VALUES[][5] = {{10, 20, 30, 40, 50}, {1, 1, 2, 3, 3}, {7, 7, 7, 1, 9}, {0, 0, 0, 0, 1}};
+    for (uint8_t v = 0; v < sizeof(VALUES) / sizeof(VALUES[0]); ++v)
+    {
+        uint8_t idx[5] = {0, 1, 2, 3, 4};
+        uint16_t permutations = 0;
+        do
+        {
+            uint16_t h[5];
+            for (uint8_t i = 0; i < 5; ++i)
+            {
+                h[i] = VALUES[v][idx[i]];
+            }
+            TEST_ASSERT_EQUAL_UINT16(sorted_median(h), RcChannel::median(h));
+            ++permutations;
+        } while (std::next_permutation(idx, idx + 5));
+        TEST_ASSERT_EQUAL_UINT16(120, permutations);
+    }
+}
+
+void test_median5_random()
+{
+    srand(1);
+    for (uint16_t n = 0; n < 10000; ++n)
+    {
+        uint16_t h[5];
+        for (uint8_t i = 0; i < 5; ++i)
+        {
+            h[i] = static_cast<uint16_t>(rand());
+        }
+        TEST_ASSERT_EQUAL_UINT16(sorted_median(h), RcChannel::median(h));
+    }
+}
+
+void test_single_outlier_is_filtered()
+{
+    RcChannel channel(2, 1500 * US);
+    for (uint8_t i = 0; i < RcChannel::FILTER_LEN; ++i)
+    {
+        channel.update(1500 * US, true, 1000);
+    }
+
+    // one corrupted pulse never reaches the output
+    channel.update(2200 * US, true, 2000);
+    TEST_ASSERT_EQUAL_UINT16(1500 * US, channel.pulse_length());
+    channel.update(1510 * US, true, 3000);
+    TEST_ASSERT_EQUAL_UINT16(1510 * US, channel.pulse_length());
+
+    // a step passes after (FILTER_LEN - 1) / 2 + 1 pulses
+    RcChannel step(2, 1500 * US);
+    for (uint8_t i = 0; i < (RcChannel::FILTER_LEN - 1) / 2; ++i)
+    {
+        step.update(1800 * US, true, 1000);
+        TEST_ASSERT_EQUAL_UINT16(1500 * US, step.pulse_length());
+    }
+    step.update(1800 * US, true, 1000);
+    TEST_ASSERT_EQUAL_UINT16(1800 * US, step.pulse_length());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_valid_pulse);
+    RUN_TEST(test_out_of_range_pulses_are_glitches);
+    RUN_TEST(test_fast_rising_edges_are_noise);
+    RUN_TEST(test_gap_across_16_bit_wrap);
+    RUN_TEST(test_started_pulse_across_wrap);
+    RUN_TEST(test_expire_keeps_recent_start);
+    RUN_TEST(test_back_to_back_start);
+    RUN_TEST(test_falling_edge_without_start);
+    RUN_TEST(test_valid_times_out);
+    RUN_TEST(test_median3_all_orders);
+    RUN_TEST(test_median5_all_orders);
+    RUN_TEST(test_median5_random);
+    RUN_TEST(test_single_outlier_is_filtered);
+    return UNITY_END();
+}
@@ -0,0 +1,324 @@
+#include "RcPwm.h"
+#include <unity.h>
+
+// simultaneous trains on the host: the compare interrupt is simulated by moving TCNT1 to OCR1A and calling the ISR
+// body; every read of TCNT1 advances it by one tick, a digitalWrite() by its execution time on the target, and port
+// writes take no time
+
+struct Write
+{
+    uint8_t pin;
+    uint8_t level;
+    uint16_t ticks;
+};
+
+static Write writes[16];
+static uint8_t write_count;
+
+static void record(uint8_t pin, uint8_t level)
+{
+    if (write_count < 16)
+    {
+        writes[write_count++] = {pin, level, mock::timer1().value};
+    }
+}
+
+static RcPwm pwm[3];
+static const uint8_t PINS[3] = {9, 10, 11};
+
+// ticks of a pulse written as \p us (pre-scaler 8)
+static uint16_t ticks(uint16_t us) { return us * 2; }
+
+// the compare interrupt
+static void fire()
+{
+    TCNT1 = OCR1A;
+    RcPwm::runImpl(false);
+}
+
+static bool anyHigh()
+{
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        if (digitalRead(PINS[i]) == HIGH)
+            return true;
+    }
+    return false;
+}
+
+// simulate compare interrupts until the train ended; returns the number of interrupts
+static uint8_t endTrain()
+{
+    uint8_t isrs = 0;
+    while (anyHigh() && isrs < 16)
+    {
+        fire();
+        ++isrs;
+    }
+    return isrs;
+}
+
+// start a train with the given widths: by runNow() if the trains stopped, else by the timer
+static void start(uint16_t us0, uint16_t us1, uint16_t us2)
+{
+    pwm[0].writeMicroseconds(us0);
+    pwm[1].writeMicroseconds(us1);
+    pwm[2].writeMicroseconds(us2);
+    write_count = 0;
+    RcPwm::runNow();
+    if (write_count == 0)
+    {
+        fire();
+    }
+}
+
+// the falls of a train, in order, end each pulse within half a microsecond after its width
+static void assertFalls(const uint8_t (&pins)[3], const uint16_t (&widths)[3])
+{
+    TEST_ASSERT_EQUAL_UINT8(3, write_count);
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(pins[i], writes[i].pin);
+        TEST_ASSERT_EQUAL_UINT8(LOW, writes[i].level);
+        TEST_ASSERT_TRUE(writes[i].ticks >= ticks(widths[i]));
+        TEST_ASSERT_TRUE(writes[i].ticks <= ticks(widths[i]) + 1);
+    }
+}
+
+void setUp()
+{
+    // end any train left over by the previous test
+    endTrain();
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        if (!pwm[i].attached())
+        {
+            pwm[i].attach(PINS[i]);
+        }
+    }
+    write_count = 0;
+}
+
+void tearDown() {}
+
+void test_train_raises_all_channels_together()
+{
+    start(1500, 1200, 1800);
+
+    // one port write before the train count starts: no channel starts late
+    TEST_ASSERT_EQUAL_UINT8(3, write_count);
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(HIGH, writes[i].level);
+        TEST_ASSERT_EQUAL_UINT8(HIGH, digitalRead(PINS[i]));
+        TEST_ASSERT_EQUAL_UINT16(writes[0].ticks, writes[i].ticks);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, mock::timer1().value);
+
+    // the compare fires ahead of the first edge, to cover the interrupt latency
+    TEST_ASSERT_EQUAL_UINT16(ticks(1200) - 8, OCR1A);
+}
+
+void test_pulse_widths_match_request()
+{
+    start(1500, 1200, 1800);
+    write_count = 0;
+    TEST_ASSERT_EQUAL_UINT8(3, endTrain());
+
+    const uint8_t order[3] = {10, 9, 11};
+    const uint16_t widths[3] = {1200, 1500, 1800};
+    assertFalls(order, widths);
+}
+
+void test_equal_widths_keep_channel_order()
+{
+    start(1600, 1600, 1600);
+    write_count = 0;
+    TEST_ASSERT_EQUAL_UINT8(1, endTrain());  // one interrupt ends all three
+
+    TEST_ASSERT_EQUAL_UINT8(3, write_count);
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(PINS[i], writes[i].pin);
+        TEST_ASSERT_TRUE(writes[i].ticks >= ticks(1600));
+        TEST_ASSERT_TRUE(writes[i].ticks <= ticks(1600) + 2 * (i + 1));  // each after its own count checks
+    }
+}
+
+void test_close_edges_end_at_their_tick()
+{
+    // 6 and 4 ticks apart: within the guard, ended by the first interrupt after waiting for their own tick
+    start(1503, 1500, 1505);
+    write_count = 0;
+    TEST_ASSERT_EQUAL_UINT8(1, endTrain());
+
+    const uint8_t order[3] = {10, 9, 11};
+    const uint16_t widths[3] = {1500, 1503, 1505};
+    assertFalls(order, widths);
+}
+
+void test_distant_edges_get_own_interrupt()
+{
+    // 40 ticks apart: beyond the guard
+    start(1500, 1520, 1540);
+    write_count = 0;
+    TEST_ASSERT_EQUAL_UINT8(3, endTrain());
+}
+
+void test_trains_repeat_every_5_ms()
+{
+    start(1500, 1200, 1800);
+    endTrain();
+    TEST_ASSERT_EQUAL_UINT16(10000, OCR1A);
+
+    // the timer starts the next train with the same widths
+    write_count = 0;
+    fire();
+    TEST_ASSERT_EQUAL_UINT8(3, write_count);
+    TEST_ASSERT_EQUAL_UINT8(HIGH, writes[0].level);
+    TEST_ASSERT_EQUAL_UINT16(0, mock::timer1().value);
+
+    write_count = 0;
+    endTrain();
+    const uint8_t order[3] = {10, 9, 11};
+    const uint16_t widths[3] = {1200, 1500, 1800};
+    assertFalls(order, widths);
+}
+
+void test_trains_stop_without_run_now()
+{
+    start(1500, 1500, 1500);
+    RcPwm::runNow();
+
+    // a refresh is requested after 25 ms of repeated trains, and again after 50 ms
+    for (uint8_t repeat = 1; repeat <= 10; ++repeat)
+    {
+        endTrain();
+        write_count = 0;
+        fire();
+        TEST_ASSERT_EQUAL_UINT8(3, write_count);
+        TEST_ASSERT_EQUAL(repeat >= 5, RcPwm::needsToRun());
+    }
+
+    // then the trains stop
+    endTrain();
+    write_count = 0;
+    fire();
+    TEST_ASSERT_EQUAL_UINT8(0, write_count);
+    TEST_ASSERT_EQUAL_UINT8(0, TCCR1B);
+
+    // until the control loop runs again
+    RcPwm::runNow();
+    TEST_ASSERT_EQUAL_UINT8(3, write_count);
+    TEST_ASSERT_FALSE(RcPwm::needsToRun());
+}
+
+void test_changes_take_effect_with_next_train()
+{
+    start(1200, 1500, 1800);
+    write_count = 0;
+
+    // reversed during the train: the running train keeps its edge list
+    pwm[0].writeMicroseconds(1800);
+    pwm[2].writeMicroseconds(1200);
+    endTrain();
+    TEST_ASSERT_EQUAL_UINT8(9, writes[0].pin);
+    TEST_ASSERT_EQUAL_UINT8(11, writes[2].pin);
+
+    fire();
+    write_count = 0;
+    endTrain();
+    TEST_ASSERT_EQUAL_UINT8(11, writes[0].pin);
+    TEST_ASSERT_EQUAL_UINT8(10, writes[1].pin);
+    TEST_ASSERT_EQUAL_UINT8(9, writes[2].pin);
+}
+
+void test_run_now_keeps_train_timing()
+{
+    start(1200, 1500, 1800);
+
+    // during a train: its pulses continue
+    write_count = 0;
+    RcPwm::runNow();
+    TEST_ASSERT_EQUAL_UINT8(0, write_count);
+    TEST_ASSERT_EQUAL_UINT16(ticks(1200) - 8, OCR1A);
+    endTrain();
+    TEST_ASSERT_EQUAL_UINT8(3, write_count);
+
+    // between trains: the next one still starts on time
+    write_count = 0;
+    RcPwm::runNow();
+    TEST_ASSERT_EQUAL_UINT8(0, write_count);
+    TEST_ASSERT_EQUAL_UINT16(10000, OCR1A);
+}
+
+void test_detached_channel_not_pulsed()
+{
+    pwm[1].detach();
+    start(1500, 1200, 1800);
+    endTrain();
+
+    TEST_ASSERT_EQUAL_UINT8(4, write_count);
+    for (uint8_t i = 0; i < write_count; ++i)
+    {
+        TEST_ASSERT_NOT_EQUAL(10, writes[i].pin);
+    }
+    TEST_ASSERT_EQUAL_UINT8(9, writes[2].pin);
+    TEST_ASSERT_EQUAL_UINT8(11, writes[3].pin);
+}
+
+void test_read_returns_written_width()
+{
+    pwm[1].attach(PINS[1]);
+    pwm[1].writeMicroseconds(1234);
+    TEST_ASSERT_EQUAL_UINT16(1234, pwm[1].readMicroseconds());
+    pwm[1].writeMicroseconds(3000);
+    TEST_ASSERT_EQUAL_UINT16(2400, pwm[1].readMicroseconds());
+}
+
+// last: stop() cannot be undone
+void test_stop_ends_pulses_and_trains()
+{
+    start(1500, 1200, 1800);
+    write_count = 0;
+    RcPwm::stop();
+
+    // the running pulses end at once
+    TEST_ASSERT_EQUAL_UINT8(3, write_count);
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(LOW, digitalRead(PINS[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, TCCR1B);
+    TEST_ASSERT_FALSE(RcPwm::needsToRun());
+
+    // no train starts again, not even from a compare that was already pending
+    write_count = 0;
+    fire();
+    RcPwm::runNow();
+    pwm[0].writeMicroseconds(1600);
+    RcPwm::runNow();
+    TEST_ASSERT_EQUAL_UINT8(0, write_count);
+    TEST_ASSERT_EQUAL_UINT8(0, TCCR1B);
+}
+
+int main(int, char**)
+{
+    mock::pins().on_write = record;
+    RcPwm::setMode(RcPwm::Mode::Simultaneous);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_train_raises_all_channels_together);
+    RUN_TEST(test_pulse_widths_match_request);
+    RUN_TEST(test_equal_widths_keep_channel_order);
+    RUN_TEST(test_close_edges_end_at_their_tick);
+    RUN_TEST(test_distant_edges_get_own_interrupt);
+    RUN_TEST(test_trains_repeat_every_5_ms);
+    RUN_TEST(test_trains_stop_without_run_now);
+    RUN_TEST(test_changes_take_effect_with_next_train);
+    RUN_TEST(test_run_now_keeps_train_timing);
+    RUN_TEST(test_detached_channel_not_pulsed);
+    RUN_TEST(test_read_returns_written_width);
+    RUN_TEST(test_stop_ends_pulses_and_trains);
+    return UNITY_END();
+}
@@ -0,0 +1,297 @@
+#include "Scheduler.h"
+#include <unity.h>
+
+static constexpr uint32_t MS = 1000UL * COUNT_PER_MICROS;
+
+// tasks log their id in run order and take run_time counts
+static char order[16];
+static uint8_t order_count;
+static uint32_t run_time;
+
+static Timer& timer() { return Timer::instance(); }
+static uint32_t now() { return timer().get_count(); }
+
+template <char ID>
+void task()
+{
+    if (order_count + 1u < sizeof(order))
+    {
+        order[order_count++] = ID;
+        order[order_count] = 0;
+    }
+    timer().bump(run_time);
+}
+
+// run until no task is ready, returns the number of runs
+template <uint8_t N>
+static uint8_t drain(Scheduler<N>& scheduler)
+{
+    uint8_t runs = 0;
+    while (scheduler.run(now()))
+    {
+        ++runs;
+    }
+    return runs;
+}
+
+void setUp()
+{
+    timer().reset();
+    TIFR2 = 0;  // write-one-to-clear on the target, a plain variable here
+    order_count = 0;
+    order[0] = 0;
+    run_time = 0;
+}
+
+void tearDown() {}
+
+void test_priority_order()
+{
+    Scheduler<3> scheduler;
+    uint8_t a = scheduler.add(task<'a'>, 0, MS);
+    uint8_t b = scheduler.add(task<'b'>, 0, MS);
+    uint8_t c = scheduler.add(task<'c'>, 0, MS);
+
+    scheduler.release(c, now());
+    scheduler.release(a, now());
+    scheduler.release(b, now());
+
+    // one task per run(), highest priority (first added) first
+    TEST_ASSERT_TRUE(scheduler.run(now()));
+    TEST_ASSERT_EQUAL_STRING("a", order);
+    TEST_ASSERT_EQUAL_UINT8(2, drain(scheduler));
+    TEST_ASSERT_EQUAL_STRING("abc", order);
+    TEST_ASSERT_FALSE(scheduler.run(now()));
+}
+
+void test_capacity()
+{
+    Scheduler<1> scheduler;
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.add(task<'a'>, 0, MS));
+    TEST_ASSERT_EQUAL_UINT8(1, scheduler.add(task<'b'>, 0, MS));
+}
+
+void test_periodic_release()
+{
+    Scheduler<1> scheduler;
+    scheduler.add(task<'p'>, 5 * MS, MS);
+
+    for (uint8_t ms = 0; ms < 20; ++ms)
+    {
+        timer().bump(MS);
+        scheduler.run(now());
+    }
+    // released at 5, 10, 15 and 20 ms
+    TEST_ASSERT_EQUAL_STRING("pppp", order);
+    TEST_ASSERT_EQUAL_UINT16(0, scheduler.overruns(0));
+}
+
+void test_missed_periods_are_skipped()
+{
+    Scheduler<1> scheduler;
+    scheduler.add(task<'p'>, 5 * MS, 100 * MS);
+
+    // 23 ms without calling run(): one release, no catch-up burst
+    timer().bump(23 * MS);
+    TEST_ASSERT_EQUAL_UINT8(1, drain(scheduler));
+    timer().bump(MS);
+    TEST_ASSERT_EQUAL_UINT8(0, drain(scheduler));
+    timer().bump(5 * MS);
+    TEST_ASSERT_EQUAL_UINT8(1, drain(scheduler));
+}
+
+void test_release_while_ready_is_overrun()
+{
+    Scheduler<1> scheduler;
+    uint8_t t = scheduler.add(task<'a'>, 0, MS);
+    scheduler.release(t, now());
+    scheduler.release(t, now());
+    TEST_ASSERT_EQUAL_UINT16(1, scheduler.overruns(t));
+    TEST_ASSERT_EQUAL_UINT8(1, drain(scheduler));
+}
+
+void test_late_start_is_overrun()
+{
+    Scheduler<2> scheduler;
+    uint8_t late = scheduler.add(task<'l'>, 0, MS);
+    uint8_t dropped = scheduler.add(task<'d'>, 0, MS, true);
+
+    scheduler.release(late, now());
+    scheduler.release(dropped, now());
+    timer().bump(2 * MS);
+
+    // the late task still runs, the droppable one is skipped
+    TEST_ASSERT_EQUAL_UINT8(1, drain(scheduler));
+    TEST_ASSERT_EQUAL_STRING("l", order);
+    TEST_ASSERT_EQUAL_UINT16(1, scheduler.overruns(late));
+    TEST_ASSERT_EQUAL_UINT16(1, scheduler.overruns(dropped));
+    TEST_ASSERT_EQUAL_UINT16(2, scheduler.overruns());
+}
+
+void test_longest_run()
+{
+    Scheduler<1> scheduler;
+    uint8_t t = scheduler.add(task<'a'>, 0, MS);
+
+    run_time = 300;
+    scheduler.release(t, now());
+    drain(scheduler);
+    run_time = 100;
+    scheduler.release(t, now());
+    drain(scheduler);
+    TEST_ASSERT_EQUAL_UINT16(300, scheduler.longest(t));
+}
+
+void test_run_over_budget_is_overrun()
+{
+    Scheduler<2> scheduler;
+    uint8_t t = scheduler.add(task<'a'>, 0, MS);
+    scheduler.setBudget(t, 200);
+
+    run_time = 200;
+    scheduler.release(t, now());
+    drain(scheduler);
+    TEST_ASSERT_EQUAL_UINT16(0, scheduler.overruns(t));
+
+    // still runs to completion, counted once
+    run_time = 201;
+    scheduler.release(t, now());
+    TEST_ASSERT_EQUAL_UINT8(1, drain(scheduler));
+    TEST_ASSERT_EQUAL_STRING("aa", order);
+    TEST_ASSERT_EQUAL_UINT16(1, scheduler.overruns(t));
+    TEST_ASSERT_EQUAL_UINT16(201, scheduler.longest(t));
+}
+
+void test_budget_is_per_task()
+{
+    Scheduler<2> scheduler;
+    uint8_t limited = scheduler.add(task<'l'>, 0, MS);
+    uint8_t free = scheduler.add(task<'f'>, 0, 10 * MS);
+    scheduler.setBudget(limited, 100);
+
+    run_time = 5000;
+    scheduler.release(limited, now());
+    scheduler.release(free, now());
+    drain(scheduler);
+    TEST_ASSERT_EQUAL_UINT16(1, scheduler.overruns(limited));
+    TEST_ASSERT_EQUAL_UINT16(0, scheduler.overruns(free));
+
+    // budget 0 removes the limit
+    scheduler.setBudget(limited, 0);
+    scheduler.release(limited, now());
+    drain(scheduler);
+    TEST_ASSERT_EQUAL_UINT16(1, scheduler.overruns(limited));
+}
+
+void test_late_and_over_budget_count_twice()
+{
+    Scheduler<1> scheduler;
+    uint8_t t = scheduler.add(task<'a'>, 0, MS);
+    scheduler.setBudget(t, 100);
+
+    scheduler.release(t, now());
+    timer().bump(MS + 1);
+    run_time = 101;
+    drain(scheduler);
+    TEST_ASSERT_EQUAL_UINT16(2, scheduler.overruns(t));
+}
+
+void test_utilisation()
+{
+    Scheduler<1> scheduler;
+    scheduler.add(task<'p'>, 10 * MS, 10 * MS);
+
+    // 2.5 ms of work every 10 ms
+    run_time = 2500UL * COUNT_PER_MICROS;
+    for (uint16_t i = 0; i < 2000; ++i)
+    {
+        scheduler.run(now());
+        timer().bump(MS / 2);
+    }
+    TEST_ASSERT_UINT8_WITHIN(1, 25, scheduler.utilisation());
+}
+
+static bool work_pending;
+static bool pending() { return work_pending; }
+
+// an interrupt wakes the CPU after 100 us
+static void wake() { timer().bump(100UL * COUNT_PER_MICROS); }
+
+void test_idle_sleeps_without_work()
+{
+    Scheduler<1> scheduler;
+    scheduler.add(task<'a'>, 0, MS);
+    uint32_t sleeps = mock::sleeps();
+    work_pending = false;
+
+    scheduler.idle(pending);
+    TEST_ASSERT_EQUAL_UINT32(sleeps + 1, mock::sleeps());
+}
+
+void test_idle_stays_awake_with_ready_task()
+{
+    Scheduler<1> scheduler;
+    uint8_t t = scheduler.add(task<'a'>, 0, MS);
+    uint32_t sleeps = mock::sleeps();
+    work_pending = false;
+
+    scheduler.release(t, now());
+    scheduler.idle(pending);
+    TEST_ASSERT_EQUAL_UINT32(sleeps, mock::sleeps());
+}
+
+void test_idle_stays_awake_with_pending_interrupt_work()
+{
+    Scheduler<1> scheduler;
+    scheduler.add(task<'a'>, 0, MS);
+    uint32_t sleeps = mock::sleeps();
+
+    // an ISR set its flag, but the task is not released yet
+    work_pending = true;
+    scheduler.idle(pending);
+    TEST_ASSERT_EQUAL_UINT32(sleeps, mock::sleeps());
+}
+
+void test_duty_cycle()
+{
+    Scheduler<1> scheduler;
+    scheduler.add(task<'p'>, 1 * MS, MS);
+    work_pending = false;
+    mock::on_sleep() = wake;
+
+    // 200 us of work per 1 ms period, the rest asleep in 100 us steps
+    run_time = 200UL * COUNT_PER_MICROS;
+    uint32_t start = now();
+    while (now() - start < 2 * Scheduler<1>::UTILISATION_WINDOW)
+    {
+        if (!scheduler.run(now()))
+        {
+            scheduler.idle(pending);
+        }
+    }
+    mock::on_sleep() = nullptr;
+
+    TEST_ASSERT_UINT8_WITHIN(2, 20, scheduler.utilisation());
+    TEST_ASSERT_UINT8_WITHIN(2, 20, scheduler.dutyCycle());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_priority_order);
+    RUN_TEST(test_capacity);
+    RUN_TEST(test_periodic_release);
+    RUN_TEST(test_missed_periods_are_skipped);
+    RUN_TEST(test_release_while_ready_is_overrun);
+    RUN_TEST(test_late_start_is_overrun);
+    RUN_TEST(test_longest_run);
+    RUN_TEST(test_run_over_budget_is_overrun);
+    RUN_TEST(test_budget_is_per_task);
+    RUN_TEST(test_late_and_over_budget_count_twice);
+    RUN_TEST(test_utilisation);
+    RUN_TEST(test_idle_sleeps_without_work);
+    RUN_TEST(test_idle_stays_awake_with_ready_task);
+    RUN_TEST(test_idle_stays_awake_with_pending_interrupt_work);
+    RUN_TEST(test_duty_cycle);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+#include "SeqLock.h"
+#include <unity.h>
+
+// value whose copy can be interrupted halfway by a simulated ISR
+struct Pair
+{
+    uint16_t a;
+    uint16_t b;
+
+    Pair& operator=(const Pair& other);
+};
+
+static void (*interrupt)() = nullptr;
+static uint8_t copies;
+
+Pair& Pair::operator=(const Pair& other)
+{
+    ++copies;
+    a = other.a;
+    if (interrupt)
+    {
+        void (*isr)() = interrupt;
+        interrupt = nullptr;
+        isr();
+    }
+    b = other.b;
+    return *this;
+}
+
+static SeqLock<Pair> lock;
+static uint16_t next_value;
+static uint8_t writes_per_interrupt;
+
+static void publish(uint16_t v)
+{
+    Pair p;
+    p.a = v;
+    p.b = v;
+    lock.write(p);
+}
+
+static void isr()
+{
+    for (uint8_t i = 0; i < writes_per_interrupt; ++i)
+    {
+        publish(next_value++);
+    }
+}
+
+void setUp()
+{
+    lock = SeqLock<Pair>();
+    interrupt = nullptr;
+    copies = 0;
+}
+
+void tearDown() {}
+
+void test_initial_value()
+{
+    Pair p;
+    TEST_ASSERT_EQUAL_UINT8(0, lock.read(p));
+    TEST_ASSERT_EQUAL_UINT16(0, p.a);
+    TEST_ASSERT_EQUAL_UINT16(0, p.b);
+}
+
+void test_read_returns_last_write()
+{
+    Pair p;
+    publish(100);
+    TEST_ASSERT_EQUAL_UINT8(1, lock.read(p));
+    TEST_ASSERT_EQUAL_UINT16(100, p.a);
+
+    publish(101);
+    publish(102);
+    TEST_ASSERT_EQUAL_UINT8(3, lock.read(p));
+    TEST_ASSERT_EQUAL_UINT16(102, p.a);
+    TEST_ASSERT_EQUAL_UINT16(102, p.b);
+}
+
+void test_sequence_wraps()
+{
+    Pair p;
+    for (uint16_t i = 1; i <= 300; ++i)
+    {
+        publish(i);
+        TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(i), lock.read(p));
+        TEST_ASSERT_EQUAL_UINT16(i, p.b);
+    }
+}
+
+void test_one_write_during_copy_needs_no_retry()
+{
+    publish(1);
+    next_value = 2;
+    writes_per_interrupt = 1;
+    interrupt = isr;
+    copies = 0;
+
+    Pair p;
+    uint8_t seq = lock.read(p);
+    // the complete previous value, no torn copy and no second copy
+    TEST_ASSERT_EQUAL_UINT8(1, seq);
+    TEST_ASSERT_EQUAL_UINT16(1, p.a);
+    TEST_ASSERT_EQUAL_UINT16(1, p.b);
+    // 1 copy by read(), 1 by the write() of the interrupt
+    TEST_ASSERT_EQUAL_UINT8(2, copies);
+
+    // the interrupting write is seen next time
+    TEST_ASSERT_EQUAL_UINT8(2, lock.read(p));
+    TEST_ASSERT_EQUAL_UINT16(2, p.a);
+}
+
+void test_two_writes_during_copy_retry()
+{
+    publish(1);
+    next_value = 2;
+    writes_per_interrupt = 2;
+    interrupt = isr;
+    copies = 0;
+
+    Pair p;
+    uint8_t seq = lock.read(p);
+    // the first copy may be torn, so it is retried and returns the newest value
+    TEST_ASSERT_EQUAL_UINT8(3, seq);
+    TEST_ASSERT_EQUAL_UINT16(3, p.a);
+    TEST_ASSERT_EQUAL_UINT16(3, p.b);
+    TEST_ASSERT_EQUAL_UINT8(2 + 2, copies);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_initial_value);
+    RUN_TEST(test_read_returns_last_write);
+    RUN_TEST(test_sequence_wraps);
+    RUN_TEST(test_one_write_during_copy_needs_no_retry);
+    RUN_TEST(test_two_writes_during_copy_retry);
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+#include "SlipEstimator.h"
+#include <unity.h>
+
+static constexpr uint32_t FRAME = 20000UL * COUNT_PER_MICROS;  // 50 Hz
+static constexpr float PI_F = 3.14159265f;
+
+// slip compensation gain and limit as used by the firmware: 1/8 gyro unit per mm/s, at most 20 degrees/s
+static constexpr uint8_t SLIP_YAW_SHIFT = 3;
+static constexpr int16_t SLIP_YAW_LIMIT = Gyro::zUnits(20);
+
+static SlipEstimator slip;
+static uint32_t now;
+
+// acceleration [accel LSB]
+static int16_t accel(float mm_s2) { return static_cast<int16_t>(mm_s2 * SlipEstimator::LSB_PER_G / 9806.65f); }
+
+static void frames(uint8_t count, float ax, float ay, int16_t rate = 0)
+{
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        now += FRAME;
+        slip.update(accel(ax), accel(ay), rate, now);
+    }
+}
+
+void setUp()
+{
+    slip = SlipEstimator();
+    now = 0;
+    slip.rest(0, 0, now);
+}
+
+void tearDown() {}
+
+void test_rest_zeroes_velocity_and_learns_bias()
+{
+    frames(10, 1000, -500);
+    TEST_ASSERT_TRUE(slip.longitudinal() > 0);
+
+    // mounting tilt: constant offsets at rest
+    for (uint16_t i = 0; i < 500; ++i)
+    {
+        now += FRAME;
+        slip.rest(accel(200), accel(-100), now);
+    }
+    TEST_ASSERT_EQUAL_INT16(0, slip.longitudinal());
+    TEST_ASSERT_EQUAL_INT16(0, slip.lateral());
+
+    // the same offsets while moving are not mistaken for acceleration
+    for (uint8_t i = 0; i < 50; ++i)
+    {
+        now += FRAME;
+        slip.update(accel(200), accel(-100), 0, now);
+    }
+    TEST_ASSERT_INT16_WITHIN(5, 0, slip.longitudinal());
+    TEST_ASSERT_INT16_WITHIN(5, 0, slip.lateral());
+}
+
+void test_forward_acceleration_integrates()
+{
+    // 1 m/s^2 for 1 s, less the ~10 s leak
+    frames(50, 1000, 0);
+    TEST_ASSERT_INT16_WITHIN(60, 950, slip.longitudinal());
+    TEST_ASSERT_EQUAL_INT16(0, slip.lateral());
+}
+
+void test_clean_turn_is_not_slip()
+{
+    frames(50, 2000, 0);
+    int16_t rate = static_cast<int16_t>(30 * Gyro::LSB_PER_DPS);
+    float rate_rad = 30 * PI_F / 180;
+
+    // centripetal acceleration of a turn without sliding: a_y = r * v_x
+    for (uint8_t i = 0; i < 50; ++i)
+    {
+        frames(1, 0, rate_rad * slip.longitudinal(), rate);
+    }
+    TEST_ASSERT_INT16_WITHIN(40, 0, slip.lateral());
+    TEST_ASSERT_TRUE(slip.longitudinal() > 1500);
+}
+
+void test_sliding_turn_shows_lateral_velocity()
+{
+    frames(50, 2000, 0);
+    int16_t rate = static_cast<int16_t>(30 * Gyro::LSB_PER_DPS);
+
+    // no side force: the craft keeps its course while the body turns left, so it slides right
+    frames(10, 0, 0, rate);
+    TEST_ASSERT_TRUE(slip.lateral() < -100);
+    TEST_ASSERT_TRUE(slip.sideslip() < -3);
+}
+
+void test_counter_yaw_in_gyro_units()
+{
+    // 1 m/s^2 sideways for 0.2 s: a few hundred mm/s, 1/8 gyro unit per mm/s
+    frames(10, 0, 1000);
+    int16_t lateral = slip.lateral();
+    TEST_ASSERT_TRUE(lateral > 100 && lateral < 8 * SLIP_YAW_LIMIT);
+    TEST_ASSERT_EQUAL_INT16(lateral >> SLIP_YAW_SHIFT, slip.counterYaw(SLIP_YAW_SHIFT, SLIP_YAW_LIMIT));
+}
+
+void test_counter_yaw_is_limited()
+{
+    frames(50, 0, 3000);
+    TEST_ASSERT_TRUE(slip.lateral() > 8 * SLIP_YAW_LIMIT);
+    TEST_ASSERT_EQUAL_INT16(82, slip.counterYaw(SLIP_YAW_SHIFT, SLIP_YAW_LIMIT));
+
+    slip.rest(0, 0, now);
+    frames(50, 0, -3000);
+    TEST_ASSERT_EQUAL_INT16(-82, slip.counterYaw(SLIP_YAW_SHIFT, SLIP_YAW_LIMIT));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rest_zeroes_velocity_and_learns_bias);
+    RUN_TEST(test_forward_acceleration_integrates);
+    RUN_TEST(test_clean_turn_is_not_slip);
+    RUN_TEST(test_sliding_turn_shows_lateral_velocity);
+    RUN_TEST(test_counter_yaw_in_gyro_units);
+    RUN_TEST(test_counter_yaw_is_limited);
+    return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include "Startup.h"
+#include <unity.h>
+
+static constexpr uint8_t ESC = 1;
+static constexpr uint8_t GYRO = 2;
+static constexpr uint8_t RX = 4;
+static constexpr uint8_t ALL = ESC | GYRO | RX;
+static constexpr uint32_t TIMEOUT_MS = 3000;
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_not_done_until_conditions_met()
+{
+    Startup startup(ALL, TIMEOUT_MS);
+    startup.start(100);
+    TEST_ASSERT_FALSE(startup.done());
+    TEST_ASSERT_FALSE(startup.update(0, 120));
+    TEST_ASSERT_EQUAL_HEX8(ALL, startup.missing());
+    TEST_ASSERT_EQUAL_UINT32(0, startup.readyTime());
+    TEST_ASSERT_EQUAL_UINT32(20, startup.elapsed(120));
+}
+
+void test_done_when_all_met_at_once()
+{
+    Startup startup(ALL, TIMEOUT_MS);
+    startup.start(0);
+    TEST_ASSERT_TRUE(startup.update(ALL, 500));
+    TEST_ASSERT_TRUE(startup.done());
+    TEST_ASSERT_EQUAL_HEX8(0, startup.missing());
+    TEST_ASSERT_EQUAL_UINT32(500, startup.readyTime());
+}
+
+void test_conditions_latch_across_frames()
+{
+    // each condition holds in a different frame only, e.g. a receiver frame dropping out
+    Startup startup(ALL, TIMEOUT_MS);
+    startup.start(0);
+    TEST_ASSERT_FALSE(startup.update(GYRO, 100));
+    TEST_ASSERT_FALSE(startup.update(RX, 200));
+    TEST_ASSERT_EQUAL_HEX8(ESC, startup.missing());
+    TEST_ASSERT_TRUE(startup.update(ESC, 1500));
+    TEST_ASSERT_EQUAL_UINT32(1500, startup.readyTime());
+}
+
+void test_unrequired_conditions_are_ignored()
+{
+    Startup startup(ESC | GYRO, TIMEOUT_MS);
+    startup.start(0);
+    TEST_ASSERT_FALSE(startup.update(RX | ESC, 100));
+    TEST_ASSERT_EQUAL_HEX8(GYRO, startup.missing());
+    TEST_ASSERT_TRUE(startup.update(GYRO, 200));
+}
+
+void test_timeout_completes_with_missing_conditions()
+{
+    Startup startup(ALL, TIMEOUT_MS);
+    startup.start(1000);
+    startup.update(ESC | GYRO, 1100);
+    TEST_ASSERT_FALSE(startup.update(0, 1000 + TIMEOUT_MS - 1));
+    TEST_ASSERT_TRUE(startup.update(0, 1000 + TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_HEX8(RX, startup.missing());
+    TEST_ASSERT_EQUAL_UINT32(1000 + TIMEOUT_MS, startup.readyTime());
+}
+
+void test_done_stays_done()
+{
+    Startup startup(ESC, TIMEOUT_MS);
+    startup.start(0);
+    startup.update(ESC, 10);
+    TEST_ASSERT_TRUE(startup.update(0, 20));
+    TEST_ASSERT_EQUAL_UINT32(10, startup.readyTime());
+}
+
+void test_restart_clears_state()
+{
+    Startup startup(ALL, TIMEOUT_MS);
+    startup.start(0);
+    startup.update(ALL, 50);
+    TEST_ASSERT_TRUE(startup.done());
+
+    startup.start(10000);
+    TEST_ASSERT_FALSE(startup.done());
+    TEST_ASSERT_EQUAL_HEX8(ALL, startup.missing());
+    TEST_ASSERT_EQUAL_UINT32(0, startup.readyTime());
+    TEST_ASSERT_FALSE(startup.update(GYRO, 10100));
+}
+
+void test_timeout_across_millis_wrap()
+{
+    Startup startup(ALL, TIMEOUT_MS);
+    startup.start(0xffffff00UL);
+    TEST_ASSERT_FALSE(startup.update(0, 0x100));
+    TEST_ASSERT_EQUAL_UINT32(0x200, startup.elapsed(0x100));
+    TEST_ASSERT_TRUE(startup.update(0, TIMEOUT_MS - 0x100));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_not_done_until_conditions_met);
+    RUN_TEST(test_done_when_all_met_at_once);
+    RUN_TEST(test_conditions_latch_across_frames);
+    RUN_TEST(test_unrequired_conditions_are_ignored);
+    RUN_TEST(test_timeout_completes_with_missing_conditions);
+    RUN_TEST(test_done_stays_done);
+    RUN_TEST(test_restart_clears_state);
+    RUN_TEST(test_timeout_across_millis_wrap);
+    return UNITY_END();
+}
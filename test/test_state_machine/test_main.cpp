@@ -0,0 +1,203 @@
+#include "HoverStates.h"
+#include <stdio.h>
+#include <unity.h>
+
+// action log: kind and state letter per call, e.g. "xHeI" for exit of Hover, enter of Idle
+static const char LETTERS[] = "XCIHFT";  // indexed by State; Init is X to tell it from Idle
+static char calls[16];
+static uint8_t call_count;
+
+static void record(char kind, State state)
+{
+    if (call_count + 2u < sizeof(calls))
+    {
+        calls[call_count++] = kind;
+        calls[call_count++] = LETTERS[static_cast<uint8_t>(state)];
+        calls[call_count] = 0;
+    }
+}
+
+static void clear()
+{
+    call_count = 0;
+    calls[0] = 0;
+}
+
+template <State S>
+void on_enter(const Frame&) { record('e', S); }
+
+template <State S>
+void on_run(const Frame&) { record('r', S); }
+
+template <State S>
+void on_exit(const Frame&) { record('x', S); }
+
+static uint8_t heading_hold_selected;
+
+void select_heading_hold(const Frame&) { ++heading_hold_selected; }
+
+#define STATE_INFO(s) {#s, on_enter<State::s>, on_run<State::s>, on_exit<State::s>}
+
+// all actions logged
+const HoverStateMachine::StateInfo STATES[] PROGMEM = {
+    STATE_INFO(Init), STATE_INFO(Calibration), STATE_INFO(Idle),
+    STATE_INFO(Hover), STATE_INFO(FailSafe), STATE_INFO(Tune),
+};
+
+// the intended behaviour, written independently of the table: next state for \p events in \p state
+static State expected(State state, uint8_t events)
+{
+    bool fail_safe = events & EVENT_FAIL_SAFE;
+    bool toggle = events & EVENT_TOGGLE_HOVER;
+    bool tune = events & EVENT_TUNE;
+
+    switch (state)
+    {
+    case State::Init: return (events & EVENT_INIT_DONE) ? State::Idle : State::Init;
+    case State::Idle:
+        if (fail_safe || !toggle)
+            return State::Idle;
+        return tune ? State::Calibration : State::Hover;
+    case State::Calibration:
+        if (fail_safe || toggle)
+            return State::Idle;
+        return (events & EVENT_CALIBRATED) ? State::Tune : State::Calibration;
+    case State::Hover:
+        if (fail_safe)
+            return State::FailSafe;
+        return toggle ? State::Idle : State::Hover;
+    case State::FailSafe: return fail_safe ? State::FailSafe : State::Hover;
+    case State::Tune: return (fail_safe || toggle || !tune) ? State::Idle : State::Tune;
+    default: return state;
+    }
+}
+
+// events leading from Init to each state
+static const uint8_t PATH_IDLE[] = {EVENT_INIT_DONE};
+static const uint8_t PATH_CALIBRATION[] = {EVENT_INIT_DONE, EVENT_TOGGLE_HOVER | EVENT_TUNE};
+static const uint8_t PATH_HOVER[] = {EVENT_INIT_DONE, EVENT_TOGGLE_HOVER};
+static const uint8_t PATH_FAIL_SAFE[] = {EVENT_INIT_DONE, EVENT_TOGGLE_HOVER, EVENT_FAIL_SAFE};
+static const uint8_t PATH_TUNE[] = {EVENT_INIT_DONE, EVENT_TOGGLE_HOVER | EVENT_TUNE, EVENT_TUNE | EVENT_CALIBRATED};
+
+struct Path
+{
+    const uint8_t* events;
+    uint8_t length;
+};
+
+#define PATH(p) {p, sizeof(p)}
+
+// indexed by State
+static const Path PATHS[] = {
+    {nullptr, 0}, PATH(PATH_CALIBRATION), PATH(PATH_IDLE), PATH(PATH_HOVER), PATH(PATH_FAIL_SAFE), PATH(PATH_TUNE),
+};
+
+static const Frame FRAME = {{1500, 1500, 1500}, 0};
+
+static HoverStateMachine machineIn(State state)
+{
+    HoverStateMachine machine(STATES, TRANSITIONS, TRANSITION_COUNT, State::Init);
+    machine.update(0, FRAME, 0);
+    const Path& path = PATHS[static_cast<uint8_t>(state)];
+    for (uint8_t i = 0; i < path.length; ++i)
+    {
+        machine.update(path.events[i], FRAME, 0);
+    }
+    return machine;
+}
+
+void setUp()
+{
+    clear();
+    heading_hold_selected = 0;
+}
+
+void tearDown() {}
+
+void test_paths_reach_each_state()
+{
+    for (uint8_t s = 0; s < static_cast<uint8_t>(State::Count); ++s)
+    {
+        TEST_ASSERT_EQUAL(s, static_cast<uint8_t>(machineIn(static_cast<State>(s)).state()));
+    }
+}
+
+void test_every_state_and_event_combination()
+{
+    for (uint8_t s = 0; s < static_cast<uint8_t>(State::Count); ++s)
+    {
+        State from = static_cast<State>(s);
+        for (uint8_t events = 0; events < bit(EVENT_COUNT); ++events)
+        {
+            HoverStateMachine machine = machineIn(from);
+            uint16_t transitions = machine.transitions();
+            clear();
+            heading_hold_selected = 0;
+
+            machine.update(events, FRAME, 0);
+
+            State to = expected(from, events);
+            char message[48];
+            snprintf(message, sizeof(message), "state %d events 0x%02x", s, events);
+            TEST_ASSERT_EQUAL_MESSAGE(static_cast<int>(to), static_cast<int>(machine.state()), message);
+
+            char log_expected[16] = {};
+            if (to == from)
+            {
+                // no transition: the state runs
+                TEST_ASSERT_EQUAL_UINT16(transitions, machine.transitions());
+                snprintf(log_expected, sizeof(log_expected), "r%c", LETTERS[s]);
+            }
+            else
+            {
+                TEST_ASSERT_EQUAL_UINT16(transitions + 1, machine.transitions());
+                snprintf(log_expected, sizeof(log_expected), "x%ce%c", LETTERS[s], LETTERS[static_cast<uint8_t>(to)]);
+            }
+            TEST_ASSERT_EQUAL_STRING(log_expected, calls);
+
+            // heading hold selection only on the Idle -> Hover transition
+            TEST_ASSERT_EQUAL_UINT8(from == State::Idle && to == State::Hover ? 1 : 0, heading_hold_selected);
+        }
+    }
+}
+
+void test_first_update_enters_initial_state()
+{
+    HoverStateMachine machine(STATES, TRANSITIONS, TRANSITION_COUNT, State::Init);
+    // events of the first update are not evaluated
+    machine.update(EVENT_INIT_DONE, FRAME, 0);
+    TEST_ASSERT_EQUAL_STRING("eX", calls);
+    TEST_ASSERT_TRUE(machine.state() == State::Init);
+    TEST_ASSERT_EQUAL_UINT16(1, machine.entries(State::Init));
+}
+
+void test_statistics()
+{
+    HoverStateMachine machine(STATES, TRANSITIONS, TRANSITION_COUNT, State::Init);
+    machine.update(0, FRAME, 0);
+    machine.update(EVENT_INIT_DONE, FRAME, 100);  // Init 100 ms
+    machine.update(EVENT_TOGGLE_HOVER, FRAME, 300);  // Idle 200 ms
+    machine.update(EVENT_TOGGLE_HOVER, FRAME, 1300);  // Hover 1000 ms
+    machine.update(EVENT_TOGGLE_HOVER, FRAME, 1400);  // Idle 100 ms
+
+    TEST_ASSERT_TRUE(machine.state() == State::Hover);
+    TEST_ASSERT_EQUAL_UINT16(4, machine.transitions());
+    TEST_ASSERT_EQUAL_UINT16(2, machine.entries(State::Idle));
+    TEST_ASSERT_EQUAL_UINT16(2, machine.entries(State::Hover));
+    TEST_ASSERT_EQUAL_UINT32(100, machine.totalTime(State::Init, 2000));
+    TEST_ASSERT_EQUAL_UINT32(300, machine.totalTime(State::Idle, 2000));
+    TEST_ASSERT_EQUAL_UINT32(1600, machine.totalTime(State::Hover, 2000));
+    TEST_ASSERT_EQUAL_UINT32(600, machine.timeInState(2000));
+    TEST_ASSERT_EQUAL_STRING("Hover", reinterpret_cast<const char*>(machine.name(State::Hover)));
+    TEST_ASSERT_EQUAL_STRING("<invalid>", reinterpret_cast<const char*>(machine.name(State::Count)));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_paths_reach_each_state);
+    RUN_TEST(test_every_state_and_event_combination);
+    RUN_TEST(test_first_update_enters_initial_state);
+    RUN_TEST(test_statistics);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+#include "Tachometer.h"
+#include <new>
+#include <unity.h>
+
+static constexpr uint8_t PIN = 5;
+static constexpr uint8_t MASK = bit(PIN);  // port D
+static constexpr uint8_t POLE_PAIRS = 7;
+
+static Tachometer* tach;
+static uint32_t now;  // [timer counts]
+
+// rpm for a pulse period [timer counts]
+static uint16_t rpm(uint32_t period) { return static_cast<uint16_t>(60000000UL * COUNT_PER_MICROS / POLE_PAIRS / period); }
+
+// \p count full periods of the ESC output, then update; the ISR passes on the rising edges only
+static void pulses(uint8_t count, uint32_t period)
+{
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        now += period;
+        tach->edges(MASK, now);
+    }
+    tach->update(now + 10);
+}
+
+void setUp()
+{
+    alignas(Tachometer) static uint8_t storage[sizeof(Tachometer)];
+    tach = new (storage) Tachometer(PIN, POLE_PAIRS);
+    now = 1000;
+}
+
+void tearDown() {}
+
+void test_stopped_initially()
+{
+    tach->update(now);
+    TEST_ASSERT_FALSE(tach->running());
+    TEST_ASSERT_EQUAL_UINT16(0, tach->rpm());
+}
+
+void test_speed_from_period()
+{
+    // 1 ms period: the first update only starts the measurement
+    pulses(3, 2000);
+    TEST_ASSERT_TRUE(tach->running());
+    TEST_ASSERT_EQUAL_UINT16(0, tach->rpm());
+
+    pulses(3, 2000);
+    TEST_ASSERT_EQUAL_UINT16(rpm(2000), tach->rpm());
+    TEST_ASSERT_EQUAL_UINT16(8571, tach->rpm());
+}
+
+void test_speed_averages_periods_between_updates()
+{
+    pulses(1, 2000);
+    tach->edges(MASK, now += 1500);
+    tach->edges(MASK, now += 2500);
+    tach->update(now + 300);
+    TEST_ASSERT_EQUAL_UINT16(rpm(2000), tach->rpm());
+}
+
+void test_other_pins_are_not_counted()
+{
+    pulses(1, 4000);
+    // rising edges of the other pins of the port change nothing
+    tach->edges(static_cast<uint8_t>(~MASK), now + 1000);
+    tach->update(now + 2000);
+    TEST_ASSERT_EQUAL_UINT16(0, tach->rpm());
+    pulses(2, 4000);
+    TEST_ASSERT_EQUAL_UINT16(rpm(4000), tach->rpm());
+}
+
+void test_stops_without_edges()
+{
+    pulses(2, 2000);
+    pulses(2, 2000);
+    TEST_ASSERT_TRUE(tach->running());
+
+    tach->update(now + Tachometer::STOP_TIMEOUT);
+    TEST_ASSERT_TRUE(tach->running());
+    tach->update(now + Tachometer::STOP_TIMEOUT + 1);
+    TEST_ASSERT_FALSE(tach->running());
+    TEST_ASSERT_EQUAL_UINT16(0, tach->rpm());
+}
+
+void test_edge_time_extends_across_16_bit_wrap()
+{
+    now = 0x1fff0UL - 3000;
+    pulses(1, 3000);
+    pulses(2, 3000);  // the 16-bit ISR timestamps wrap here
+    TEST_ASSERT_EQUAL_UINT16(rpm(3000), tach->rpm());
+}
+
+// the tachometer port's ISR: returns on falling edges, before the time is read
+static uint8_t isr_reads;
+
+static void isr(uint8_t pins, uint32_t at)
+{
+    uint8_t rising = PinChange::rising(2, pins);
+    if (rising == 0)
+        return;
+
+    ++isr_reads;
+    tach->edges(rising, at);
+}
+
+void test_setup_counts_rising_edges_only()
+{
+    PIND = 0;
+    tach->setup();
+    TEST_ASSERT_EQUAL_UINT8(INPUT_PULLUP, mock::pins().mode[PIN]);
+    TEST_ASSERT_TRUE(PCMSK2 & MASK);
+
+    // two updates of two periods each through the ISR
+    isr_reads = 0;
+    for (uint8_t update = 0; update < 2; ++update)
+    {
+        for (uint8_t i = 0; i < 2; ++i)
+        {
+            isr(0, now + 1000);
+            now += 2000;
+            isr(MASK, now);
+        }
+        tach->update(now + 10);
+    }
+    TEST_ASSERT_EQUAL_UINT16(rpm(2000), tach->rpm());
+    TEST_ASSERT_EQUAL_UINT8(4, isr_reads);
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stopped_initially);
+    RUN_TEST(test_speed_from_period);
+    RUN_TEST(test_speed_averages_periods_between_updates);
+    RUN_TEST(test_other_pins_are_not_counted);
+    RUN_TEST(test_stops_without_edges);
+    RUN_TEST(test_edge_time_extends_across_16_bit_wrap);
+    RUN_TEST(test_setup_counts_rising_edges_only);
+    return UNITY_END();
+}
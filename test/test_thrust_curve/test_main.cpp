@@ -0,0 +1,107 @@
+#include "ThrustCurve.h"
+#include <unity.h>
+
+void setUp() {}
+void tearDown() {}
+
+void test_isqrt()
+{
+    TEST_ASSERT_EQUAL_UINT32(0, int_math::isqrt(0));
+    TEST_ASSERT_EQUAL_UINT32(1, int_math::isqrt(1));
+    TEST_ASSERT_EQUAL_UINT32(1, int_math::isqrt(2));
+    TEST_ASSERT_EQUAL_UINT32(1, int_math::isqrt(3));
+    TEST_ASSERT_EQUAL_UINT32(2, int_math::isqrt(4));
+    TEST_ASSERT_EQUAL_UINT32(255, int_math::isqrt(65535));
+    TEST_ASSERT_EQUAL_UINT32(256, int_math::isqrt(65536));
+    TEST_ASSERT_EQUAL_UINT32(65535, int_math::isqrt(0xffffffffUL));
+    TEST_ASSERT_EQUAL_UINT32(65535, int_math::isqrt(0xfffe0001UL));
+    TEST_ASSERT_EQUAL_UINT32(65534, int_math::isqrt(0xfffe0000UL));
+    for (uint32_t n = 0; n < 100000; ++n)
+    {
+        uint32_t r = int_math::isqrt(n);
+        TEST_ASSERT_TRUE(r * r <= n && (r + 1) * (r + 1) > n);
+    }
+}
+
+void test_quadratic_table()
+{
+    const uint16_t* table = thrust_curve::QuadraticTable<375>::values;
+    TEST_ASSERT_EQUAL_UINT16(0, pgm_read_word(&table[0]));
+    TEST_ASSERT_EQUAL_UINT16(375 / 2, pgm_read_word(&table[4]));  // quarter thrust at half offset
+    TEST_ASSERT_EQUAL_UINT16(375, pgm_read_word(&table[16]));
+    for (uint8_t i = 1; i < ThrustCurve::POINTS; ++i)
+    {
+        TEST_ASSERT_GREATER_THAN(pgm_read_word(&table[i - 1]), pgm_read_word(&table[i]));
+    }
+}
+
+void test_full_thrust_per_battery()
+{
+    static const uint16_t FULL_US[] = {480, 375, 250, 187, 187};
+    ThrustCurve curve;
+    for (uint8_t cells = 1; cells <= 5; ++cells)
+    {
+        curve.select(ThrustCurve::forCells(cells));
+        TEST_ASSERT_EQUAL_INT16(FULL_US[cells - 1], curve.toMicroseconds(ThrustCurve::THRUST_MAX));
+    }
+}
+
+void test_symmetric_and_clamped()
+{
+    ThrustCurve curve;
+    TEST_ASSERT_EQUAL_INT16(0, curve.toMicroseconds(0));
+    for (int16_t t = 0; t <= ThrustCurve::THRUST_MAX; t += 13)
+    {
+        TEST_ASSERT_EQUAL_INT16(-curve.toMicroseconds(t), curve.toMicroseconds(-t));
+    }
+    TEST_ASSERT_EQUAL_INT16(375, curve.toMicroseconds(2000));
+    TEST_ASSERT_EQUAL_INT16(-375, curve.toMicroseconds(-2000));
+}
+
+void test_interpolation_is_monotonic()
+{
+    ThrustCurve curve;
+    int16_t prev = 0;
+    for (int16_t t = 1; t <= ThrustCurve::THRUST_MAX; ++t)
+    {
+        int16_t us = curve.toMicroseconds(t);
+        TEST_ASSERT_GREATER_OR_EQUAL(prev, us);
+        prev = us;
+    }
+}
+
+void test_linearises_quadratic_fan()
+{
+    // thrust ~ offset^2: the offset for a thrust command is close to sqrt(thrust / THRUST_MAX) * full offset
+    ThrustCurve curve;
+    for (int16_t t = 64; t <= ThrustCurve::THRUST_MAX; t += 32)
+    {
+        float expected = 375.0f * sqrtf(static_cast<float>(t) / ThrustCurve::THRUST_MAX);
+        TEST_ASSERT_INT16_WITHIN(4, static_cast<int16_t>(expected), curve.toMicroseconds(t));
+    }
+}
+
+void test_custom_table()
+{
+    static const uint16_t LINEAR[ThrustCurve::POINTS] PROGMEM = {
+        0, 25, 50, 75, 100, 125, 150, 175, 200, 225, 250, 275, 300, 325, 350, 375, 400
+    };
+    ThrustCurve curve;
+    curve.select(LINEAR);
+    TEST_ASSERT_EQUAL_INT16(200, curve.toMicroseconds(256));
+    TEST_ASSERT_EQUAL_INT16(-100, curve.toMicroseconds(-128));
+    TEST_ASSERT_EQUAL_INT16(12, curve.toMicroseconds(16));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_isqrt);
+    RUN_TEST(test_quadratic_table);
+    RUN_TEST(test_full_thrust_per_battery);
+    RUN_TEST(test_symmetric_and_clamped);
+    RUN_TEST(test_interpolation_is_monotonic);
+    RUN_TEST(test_linearises_quadratic_fan);
+    RUN_TEST(test_custom_table);
+    return UNITY_END();
+}
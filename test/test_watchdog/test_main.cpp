@@ -0,0 +1,158 @@
+#include "RcPwm.h"
+#include "Watchdog.h"
+#include <Wire.h>
+#include <unity.h>
+
+// the .init3 hook and the watchdog vector; plain functions on the host
+void watchdog_init3();
+extern "C" void WDT_vect();
+extern "C" void TIMER1_COMPA_vect();
+
+// the watchdog hardware in interrupt and system reset mode: the first timeout clears WDIE and calls the ISR, the
+// next one resets the MCU; returns true on reset
+static bool timeout()
+{
+    if (WDTCSR & bit(WDIE))
+    {
+        WDTCSR &= ~bit(WDIE);
+        WDT_vect();
+        return false;
+    }
+    return (WDTCSR & bit(WDE)) != 0;
+}
+
+// a reset with the cause \p mcusr: the watchdog stays enabled after a watchdog reset, until .init3 stops it
+static void restart(uint8_t mcusr)
+{
+    MCUSR = mcusr;
+    WDTCSR = (mcusr & bit(WDRF)) ? bit(WDE) : 0;
+    watchdog_init3();
+}
+
+// the expiry handler of main.cpp
+static void on_expiry() { RcPwm::stop(); }
+
+static RcPwm pwm[3];
+static const uint8_t PINS[3] = {9, 10, 11};
+static uint8_t write_count;
+
+static void record(uint8_t, uint8_t) { ++write_count; }
+
+void setUp()
+{
+    Wire = TwoWire();
+    mock::wdt_resets() = 0;
+    write_count = 0;
+}
+
+void tearDown() {}
+
+void test_power_on_starts_watchdog()
+{
+    restart(bit(PORF));
+    Watchdog::setup(WDTO_120MS, on_expiry);
+
+    TEST_ASSERT_FALSE(Watchdog::caused_reset());
+    TEST_ASSERT_EQUAL_UINT8(0, MCUSR);
+    TEST_ASSERT_EQUAL_HEX32(bit(WDIE) | bit(WDE) | WDTO_120MS, WDTCSR);
+}
+
+void test_kick_restarts_timeout()
+{
+    Watchdog::kick();
+    Watchdog::kick();
+    TEST_ASSERT_EQUAL_UINT32(2, mock::wdt_resets());
+}
+
+void test_stalled_loop_gets_safe_outputs()
+{
+    // a train is running when the control loop stalls on the bus
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        pwm[i].writeMicroseconds(1500);
+    }
+    RcPwm::runNow();
+    TCNT1 = OCR1A;
+    TIMER1_COMPA_vect();
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(HIGH, digitalRead(PINS[i]));
+    }
+
+    Wire.hung = true;
+    Wire.beginTransmission(0x68);
+    Wire.write(0x3b);
+    TEST_ASSERT_NOT_EQUAL(0, Wire.endTransmission());
+
+    // no kick: the watchdog interrupt ends the pulses and the timer
+    TEST_ASSERT_FALSE(timeout());
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(LOW, digitalRead(PINS[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, TCCR1B);
+
+    // neither a pending compare nor the recovering loop starts further trains
+    write_count = 0;
+    TIMER1_COMPA_vect();
+    RcPwm::runNow();
+    TEST_ASSERT_EQUAL_UINT8(0, write_count);
+    TEST_ASSERT_FALSE(RcPwm::needsToRun());
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        TEST_ASSERT_EQUAL_UINT8(LOW, digitalRead(PINS[i]));
+    }
+}
+
+void test_second_timeout_resets()
+{
+    // the loop recovered, but its kicks no longer restart the timeout
+    Watchdog::kick();
+    TEST_ASSERT_EQUAL_UINT32(0, mock::wdt_resets());
+    TEST_ASSERT_TRUE(timeout());
+}
+
+void test_restart_reports_watchdog_reset()
+{
+    restart(bit(WDRF));
+
+    // stopped before the C runtime, so the 15 ms reset timeout cannot loop
+    TEST_ASSERT_EQUAL_UINT8(0, WDTCSR);
+    TEST_ASSERT_EQUAL_UINT8(0, MCUSR);
+
+    Watchdog::setup(WDTO_120MS, on_expiry);
+    TEST_ASSERT_TRUE(Watchdog::caused_reset());
+}
+
+void test_marker_reports_reset_after_bootloader_cleared_mcusr()
+{
+    TEST_ASSERT_FALSE(timeout());
+    TEST_ASSERT_TRUE(timeout());
+    restart(0);
+    Watchdog::setup(WDTO_120MS, on_expiry);
+    TEST_ASSERT_TRUE(Watchdog::caused_reset());
+
+    // the marker is consumed: the next external reset is not reported
+    restart(bit(EXTRF));
+    Watchdog::setup(WDTO_120MS, on_expiry);
+    TEST_ASSERT_FALSE(Watchdog::caused_reset());
+}
+
+int main(int, char**)
+{
+    RcPwm::setMode(RcPwm::Mode::Simultaneous);
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        pwm[i].attach(PINS[i]);
+    }
+    mock::pins().on_write = record;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_power_on_starts_watchdog);
+    RUN_TEST(test_kick_restarts_timeout);
+    RUN_TEST(test_stalled_loop_gets_safe_outputs);
+    RUN_TEST(test_second_timeout_resets);
+    RUN_TEST(test_restart_reports_watchdog_reset);
+    RUN_TEST(test_marker_reports_reset_after_bootloader_cleared_mcusr);
+    return UNITY_END();
+}
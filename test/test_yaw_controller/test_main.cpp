@@ -0,0 +1,107 @@
+#include "YawController.h"
+#include <unity.h>
+
+static const YawController::Gains GAINS = {32, 2, 8, 64};
+static constexpr int16_t LIMIT = 400;
+
+void setUp() {}
+void tearDown() {}
+
+void test_zero_error_gives_zero_output()
+{
+    YawController c(GAINS, LIMIT);
+    for (uint8_t i = 0; i < 10; ++i)
+    {
+        TEST_ASSERT_EQUAL_INT16(0, c.update(0, 0, 0, 32));
+    }
+    TEST_ASSERT_EQUAL_INT16(0, c.integral());
+}
+
+void test_proportional_term_and_gain_schedule()
+{
+    // full gain: kp 0.5 on an error of 100
+    YawController full(GAINS, LIMIT);
+    TEST_ASSERT_EQUAL_INT16(50 + 3, full.update(0, 100, 0, 32));
+
+    // kp_scale 0 halves the proportional term
+    YawController half(GAINS, LIMIT);
+    TEST_ASSERT_EQUAL_INT16(25 + 3, half.update(0, 100, 0, 0));
+}
+
+void test_feed_forward_follows_stick()
+{
+    YawController c(GAINS, LIMIT);
+    // no rate error: only the feed-forward (1.0) is left
+    TEST_ASSERT_EQUAL_INT16(120, c.update(120, 0, 0, 32));
+    TEST_ASSERT_EQUAL_INT16(-120, c.update(-120, 0, 0, 32));
+}
+
+void test_integral_removes_steady_error()
+{
+    YawController c(GAINS, LIMIT);
+    int16_t first = c.update(0, 20, 0, 32);
+    int16_t out = first;
+    for (uint8_t i = 0; i < 50; ++i)
+    {
+        out = c.update(0, 20, 0, 32);
+    }
+    TEST_ASSERT_GREATER_THAN(first, out);
+    TEST_ASSERT_GREATER_THAN(0, c.integral());
+}
+
+void test_output_is_limited()
+{
+    YawController c(GAINS, LIMIT);
+    TEST_ASSERT_EQUAL_INT16(LIMIT, c.update(1000, 2000, 0, 32));
+    TEST_ASSERT_EQUAL_INT16(-LIMIT, c.update(-1000, -2000, 0, 32));
+}
+
+void test_anti_windup()
+{
+    YawController c(GAINS, LIMIT);
+    // saturate for a long time, the integrator stays bounded by the limit
+    for (uint16_t i = 0; i < 1000; ++i)
+    {
+        TEST_ASSERT_EQUAL_INT16(LIMIT, c.update(0, 2000, 0, 32));
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(LIMIT, c.integral());
+
+    // the output leaves saturation as soon as the error reverses
+    int16_t out = c.update(0, -100, 0, 32);
+    TEST_ASSERT_LESS_THAN(LIMIT, out);
+}
+
+void test_derivative_opposes_rate_change()
+{
+    YawController c(GAINS, LIMIT);
+    c.update(0, 0, 0, 32);
+    // the rate jumps onto the setpoint: no error left, the derivative term pushes back
+    int16_t out = c.update(0, 100, 100, 32);
+    TEST_ASSERT_LESS_THAN(0, out);
+}
+
+void test_reset_clears_state()
+{
+    YawController c(GAINS, LIMIT);
+    for (uint8_t i = 0; i < 20; ++i)
+    {
+        c.update(0, 100, 0, 32);
+    }
+    c.reset();
+    TEST_ASSERT_EQUAL_INT16(0, c.integral());
+    TEST_ASSERT_EQUAL_INT16(0, c.update(0, 0, 0, 32));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_zero_error_gives_zero_output);
+    RUN_TEST(test_proportional_term_and_gain_schedule);
+    RUN_TEST(test_feed_forward_follows_stick);
+    RUN_TEST(test_integral_removes_steady_error);
+    RUN_TEST(test_output_is_limited);
+    RUN_TEST(test_anti_windup);
+    RUN_TEST(test_derivative_opposes_rate_change);
+    RUN_TEST(test_reset_clears_state);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Compare an on-target profile against a recorded baseline.
+
+Input is the serial output of a firmware built with the "profile" environment
+(pio run -e profile), e.g. captured with
+
+    pio device monitor -e profile | tee profile.log
+
+Each report line reads "PRF <name> <count> <mean us> <max us>", times to
+0.1 us. The worst mean and maximum per point over the whole log are compared
+against the baseline CSV; the script exits non-zero if any point got slower by
+more than --threshold percent (and more than one Timer tick), if a point is
+missing from the log or from the baseline, or if there is no baseline at all.
+Use --update to record the log as the new baseline.
+
+The timings only mean something on the target (AVR at 16 MHz), so this is a
+manual check before merging changes to the hot paths, not a CI step. The
+committed tools/profile_baseline.csv has no points until the first capture on
+hardware is recorded with --update and committed; until then the check fails,
+so an unrecorded baseline cannot pass as "no regression".
+"""
+
+import argparse
+import csv
+import sys
+
+# Timer count resolution [us]; smaller differences are measurement noise
+RESOLUTION_US = 0.5
+
+
+def load_log(path):
+    points = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) != 5 or fields[0] != "PRF":
+                continue
+            try:
+                name, count, mean, worst = fields[1], int(fields[2]), float(fields[3]), float(fields[4])
+            except ValueError:
+                continue
+            if count == 0:
+                continue
+            old_mean, old_max = points.get(name, (0, 0))
+            points[name] = (max(old_mean, mean), max(old_max, worst))
+    return points
+
+
+def load_baseline(path):
+    try:
+        with open(path, newline="") as f:
+            return {row["name"]: (float(row["mean_us"]), float(row["max_us"])) for row in csv.DictReader(f)}
+    except FileNotFoundError:
+        sys.exit("no baseline %s; record one with --update" % path)
+
+
+def save_baseline(path, points):
+    with open(path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["name", "mean_us", "max_us"])
+        for name in sorted(points):
+            writer.writerow([name] + list(points[name]))
+
+
+def regressed(new, old, threshold):
+    return new > old + RESOLUTION_US and new > old * (1 + threshold / 100)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="captured serial output of the profile build")
+    parser.add_argument("--baseline", default="tools/profile_baseline.csv", help="baseline CSV")
+    parser.add_argument("--threshold", type=float, default=10, help="allowed slowdown [%%]")
+    parser.add_argument("--update", action="store_true", help="write the log as new baseline")
+    args = parser.parse_args()
+
+    points = load_log(args.log)
+    if not points:
+        sys.exit("no profile lines in %s" % args.log)
+
+    if args.update:
+        save_baseline(args.baseline, points)
+        print("baseline %s updated with %d points" % (args.baseline, len(points)))
+        return
+
+    baseline = load_baseline(args.baseline)
+    failed = False
+    for name in sorted(set(points) | set(baseline)):
+        if name not in points:
+            print("%-14s missing from log" % name)
+            failed = True
+            continue
+        mean, worst = points[name]
+        if name not in baseline:
+            print("%-14s mean %7.1f us  max %7.1f us  NO BASELINE" % (name, mean, worst))
+            failed = True
+            continue
+        base_mean, base_max = baseline[name]
+        bad = regressed(mean, base_mean, args.threshold) or regressed(worst, base_max, args.threshold)
+        failed |= bad
+        print("%-14s mean %7.1f us (%7.1f)  max %7.1f us (%7.1f)%s" %
+              (name, mean, base_mean, worst, base_max, "  REGRESSION" if bad else ""))
+
+    if not baseline:
+        print("baseline %s has no points; record it on the target with --update" % args.baseline)
+        failed = True
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
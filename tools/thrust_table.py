@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Build a ThrustCurve table from thrust-stand measurements.
+
+Input is a CSV file with an ESC offset from the zero-thrust point [us] and the
+measured thrust (any unit) per row, e.g.
+
+    us,thrust
+    0,0
+    50,12
+    100,41
+    ...
+
+The measured curve is inverted so that table point i (0..16) holds the ESC
+offset producing i/16 of the thrust measured at --max-us. The output is a
+PROGMEM table to paste into the firmware and pass to ThrustCurve::select().
+"""
+
+import argparse
+import csv
+import sys
+
+POINTS = 17
+
+
+def load(path):
+    rows = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            rows.append((float(row["us"]), float(row["thrust"])))
+    rows.sort()
+    return rows
+
+
+def interpolate(points, x):
+    """Linear interpolation of y(x) over points sorted by x."""
+    for (x0, y0), (x1, y1) in zip(points, points[1:]):
+        if x0 <= x <= x1:
+            return y0 if x1 == x0 else y0 + (y1 - y0) * (x - x0) / (x1 - x0)
+    raise ValueError("%g outside measured range" % x)
+
+
+def build_table(rows, max_us):
+    full_thrust = interpolate(rows, max_us)
+    inverse = sorted((thrust, us) for us, thrust in rows if us <= max_us)
+    inverse.append((full_thrust, max_us))
+    return [round(interpolate(inverse, full_thrust * i / (POINTS - 1))) for i in range(POINTS)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("csv", help="thrust-stand measurements (columns: us, thrust)")
+    parser.add_argument("--max-us", type=float, required=True, help="ESC offset at full thrust [us]")
+    parser.add_argument("--name", default="THRUST_TABLE_MEASURED", help="name of the generated table")
+    args = parser.parse_args()
+
+    table = build_table(load(args.csv), args.max_us)
+    if any(b < a for a, b in zip(table, table[1:])):
+        sys.exit("measured thrust is not monotonic in ESC offset")
+
+    print("// generated by tools/thrust_table.py from %s" % args.csv)
+    print("const uint16_t %s[ThrustCurve::POINTS] PROGMEM = {" % args.name)
+    print("    " + ", ".join(str(v) for v in table))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
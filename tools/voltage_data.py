@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Export the pack voltage log voltage_data.xlsx for the host tests.
+
+The workbook holds one row per telemetry sample: RC inputs, the fan commands
+tx_r, tx_l and tx_hm [us], state columns and the pack voltage V [V]. Rows
+without numbers (notes below the log) are dropped.
+
+    tools/voltage_data.py csv voltage_data.xlsx > test/test_battery/voltage_data.csv
+    tools/voltage_data.py header test/test_battery/voltage_data.csv > test/test_battery/voltage_data.h
+
+The header holds the fan commands and the voltage [mV] of each row, replayed by
+test_battery. Only the Python standard library is used, no spreadsheet module.
+"""
+
+import argparse
+import csv
+import re
+import sys
+import xml.etree.ElementTree as ET
+import zipfile
+
+NS = "{http://schemas.openxmlformats.org/spreadsheetml/2006/main}"
+
+
+def read_xlsx(path):
+    """Rows of the first sheet as lists of strings."""
+    with zipfile.ZipFile(path) as z:
+        strings = [
+            "".join(t.text or "" for t in si.iter(NS + "t"))
+            for si in ET.fromstring(z.read("xl/sharedStrings.xml")).iter(NS + "si")
+        ]
+        sheet = ET.fromstring(z.read("xl/worksheets/sheet1.xml"))
+
+    rows = []
+    for row in sheet.iter(NS + "row"):
+        cells = {}
+        for c in row.iter(NS + "c"):
+            col = ord(re.match(r"[A-Z]", c.get("r")).group()) - ord("A")
+            v = c.find(NS + "v")
+            value = "" if v is None else v.text
+            if c.get("t") == "s":
+                value = strings[int(value)]
+            elif value:
+                value = "%g" % float(value)  # undo binary float noise, e.g. 8.0399999999999991
+            cells[col] = value
+        rows.append([cells.get(i, "") for i in range(max(cells) + 1)] if cells else [])
+    return rows
+
+
+def export_csv(path):
+    rows = read_xlsx(path)
+    header, rows = rows[0], rows[1:]
+    writer = csv.writer(sys.stdout, lineterminator="\n")
+    writer.writerow(header)
+    for row in rows:
+        if row and re.match(r"-?\d", row[0]):
+            writer.writerow(row + [""] * (len(header) - len(row)))
+
+
+def export_header(path):
+    with open(path, newline="") as f:
+        rows = list(csv.DictReader(f))
+
+    print("// generated by tools/voltage_data.py from %s" % path)
+    print("// fan commands tx_r, tx_l, tx_hm [us] and pack voltage [mV] per telemetry sample")
+    print("#pragma once")
+    print()
+    print("#include <stdint.h>")
+    print()
+    print("struct VoltageSample")
+    print("{")
+    print("    int16_t tx_r;")
+    print("    int16_t tx_l;")
+    print("    int16_t tx_hm;")
+    print("    int16_t mv;")
+    print("};")
+    print()
+    print("static const VoltageSample VOLTAGE_DATA[] = {")
+    for row in rows:
+        print("    {%s, %s, %s, %d}," % (row["tx_r"], row["tx_l"], row["tx_hm"], round(float(row["V"]) * 1000)))
+    print("};")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("format", choices=["csv", "header"])
+    parser.add_argument("input", help="voltage_data.xlsx for csv, the exported CSV for header")
+    args = parser.parse_args()
+
+    if args.format == "csv":
+        export_csv(args.input)
+    else:
+        export_header(args.input)
+
+
+if __name__ == "__main__":
+    main()